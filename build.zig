@@ -25,23 +25,36 @@ pub fn build(b: *std.Build) void {
         "-fstack-protector-strong",
         "-fPIE",
     };
+    // Everything but the entry point and platform code, shared with the tests.
+    const sources = [_][]const u8{
+        "src/core/frame_arena.cpp",
+        "src/core/thread_pool.cpp",
+        "src/core/transform.cpp",
+        "src/geometry/generator.cpp",
+        "src/render/buffer.cpp",
+        "src/render/camera.cpp",
+        "src/render/coverage.cpp",
+        "src/render/deferred_render_pipeline.cpp",
+        "src/render/clipper.cpp",
+        "src/render/forward_render_pipeline.cpp",
+        "src/render/gbuffer.cpp",
+        "src/render/mesh.cpp",
+        "src/render/pipeline_state.cpp",
+        "src/render/rasterizer.cpp",
+        "src/render/sampler.cpp",
+        "src/render/texture.cpp",
+        "src/render/visibility_buffer.cpp",
+        "src/render/visibility_render_pipeline.cpp",
+        "src/shader/shader.cpp",
+        "src/window/swap_chain.cpp",
+    };
     const exe = b.addExecutable(.{
         .name = "softy",
         .target = target,
         .optimize = mode,
     });
     exe.addCSourceFiles(.{
-        .files = &.{
-            "src/main.cpp",
-            "src/core/transform.cpp",
-            "src/geometry/generator.cpp",
-            "src/render/buffer.cpp",
-            "src/render/camera.cpp",
-            "src/render/forward_render_pipeline.cpp",
-            "src/render/mesh.cpp",
-            "src/render/rasterizer.cpp",
-            "src/shader/shader.cpp",
-        },
+        .files = &([_][]const u8{"src/main.cpp"} ++ sources),
         .flags = &flags,
         .language = .cpp,
     });
@@ -78,9 +91,7 @@ pub fn build(b: *std.Build) void {
         .optimize = mode,
     });
     tester.addCSourceFiles(.{
-        .files = &.{
-            "tests/tester.cpp",
-        },
+        .files = &([_][]const u8{"tests/tester.cpp"} ++ sources),
         .flags = &flags,
         .language = .cpp,
     });
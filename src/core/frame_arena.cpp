@@ -0,0 +1,90 @@
+#include "core/frame_arena.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace softy {
+static constexpr std::size_t ChunkAlignment = 64;
+static constexpr std::size_t MinChunkSize = 1uz << 20;
+
+static std::byte* AllocateChunk(std::size_t size) {
+  return static_cast<std::byte*>(
+      ::operator new(size, std::align_val_t{ChunkAlignment}));
+}
+
+static void FreeChunk(std::byte* data) {
+  ::operator delete(data, std::align_val_t{ChunkAlignment});
+}
+
+// Every live arena, for ResetAll.
+static std::mutex arenasMutex;
+static std::vector<FrameArena*> arenas;
+
+FrameArena::FrameArena() {
+  std::lock_guard lock{arenasMutex};
+  arenas.push_back(this);
+}
+
+FrameArena::~FrameArena() {
+  for (Chunk& chunk : chunks_) {
+    FreeChunk(chunk.data);
+  }
+
+  std::lock_guard lock{arenasMutex};
+  std::erase(arenas, this);
+}
+
+void* FrameArena::Allocate(std::size_t bytes, std::size_t alignment) {
+  assert(std::has_single_bit(alignment) && alignment <= ChunkAlignment);
+  if (!chunks_.empty()) {
+    std::size_t offset = (offset_ + alignment - 1uz) & ~(alignment - 1uz);
+    if (offset + bytes <= chunks_.back().size) {
+      offset_ = offset + bytes;
+      return chunks_.back().data + offset;
+    }
+  }
+
+  std::size_t size = chunks_.empty() ? MinChunkSize : chunks_.back().size * 2;
+  size = std::max(size, std::bit_ceil(bytes));
+  chunks_.push_back(Chunk{.data = AllocateChunk(size), .size = size});
+  offset_ = bytes;
+  return chunks_.back().data;
+}
+
+void FrameArena::Reset() {
+  if (chunks_.size() > 1) {
+    std::size_t size = GetCapacity();
+    for (Chunk& chunk : chunks_) {
+      FreeChunk(chunk.data);
+    }
+    chunks_.clear();
+    chunks_.push_back(Chunk{.data = AllocateChunk(size), .size = size});
+  }
+  offset_ = 0;
+}
+
+std::size_t FrameArena::GetCapacity() const noexcept {
+  std::size_t capacity{};
+  for (const Chunk& chunk : chunks_) {
+    capacity += chunk.size;
+  }
+  return capacity;
+}
+
+FrameArena& FrameArena::ForThread() {
+  thread_local FrameArena arena;
+  return arena;
+}
+
+void FrameArena::ResetAll() {
+  std::lock_guard lock{arenasMutex};
+  for (FrameArena* arena : arenas) {
+    arena->Reset();
+  }
+}
+}  // namespace softy
\ No newline at end of file
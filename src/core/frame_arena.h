@@ -0,0 +1,76 @@
+#ifndef CORE_FRAME_ARENA_H_
+#define CORE_FRAME_ARENA_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace softy {
+// Bump allocator for memory that lives for at most one frame. Frees nothing
+// until Reset, which frees everything. A frame that outgrows the arena's
+// chunk makes the arena grow to fit the whole frame in one chunk, so once
+// warmed up it stops allocating.
+class FrameArena {
+ public:
+  FrameArena();
+  ~FrameArena();
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+  FrameArena(FrameArena&&) = delete;
+  FrameArena& operator=(FrameArena&&) = delete;
+
+  // alignment must be a power of two no larger than a cache line.
+  void* Allocate(std::size_t bytes, std::size_t alignment);
+  void Reset();
+
+  std::size_t GetCapacity() const noexcept;
+
+  // The calling thread's arena.
+  static FrameArena& ForThread();
+  // Resets every arena. No thread may be using its arena meanwhile.
+  static void ResetAll();
+
+ private:
+  struct Chunk {
+    std::byte* data;
+    std::size_t size;
+  };
+
+  std::vector<Chunk> chunks_;
+  std::size_t offset_{};
+};
+
+// Allocates from a FrameArena, by default that of the thread constructing
+// the allocator. Deallocation is a no-op.
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  ArenaAllocator() noexcept : arena_{&FrameArena::ForThread()} {}
+  explicit ArenaAllocator(FrameArena& arena) noexcept : arena_{&arena} {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& allocator) noexcept
+      : arena_{allocator.GetArena()} {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T*, std::size_t) noexcept {}
+
+  FrameArena* GetArena() const noexcept { return arena_; }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& allocator) const noexcept {
+    return arena_ == allocator.GetArena();
+  }
+
+ private:
+  FrameArena* arena_;
+};
+
+// Transient storage of the pipeline. Must not outlive the frame.
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+}  // namespace softy
+
+#endif  // CORE_FRAME_ARENA_H_
\ No newline at end of file
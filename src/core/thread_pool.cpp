@@ -0,0 +1,98 @@
+#include "core/thread_pool.h"
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace softy {
+ThreadPool::ThreadPool(std::size_t threadCount) {
+  std::size_t workerCount = threadCount > 1uz ? threadCount - 1uz : 0uz;
+  workers_.reserve(workerCount);
+  for (std::size_t i = 0; i < workerCount; ++i) {
+    workers_.emplace_back([this]() { WorkerLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock{mutex_};
+    stop_ = true;
+  }
+  wake_.notify_all();
+
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::ParallelFor(std::size_t count, const Job& job) {
+  if (count == 0) {
+    return;
+  }
+
+  if (workers_.empty() || count == 1) {
+    for (std::size_t i = 0; i < count; ++i) {
+      job(i);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard lock{mutex_};
+    assert(job_ == nullptr && "ParallelFor is not reentrant");
+    job_ = &job;
+    count_ = count;
+    next_.store(0, std::memory_order_relaxed);
+    pending_ = workers_.size();
+    ++generation_;
+  }
+  wake_.notify_all();
+
+  RunJobs();
+
+  std::unique_lock lock{mutex_};
+  done_.wait(lock, [this]() { return pending_ == 0; });
+  job_ = nullptr;
+}
+
+ThreadPool& ThreadPool::Instance() {
+  static ThreadPool pool{std::thread::hardware_concurrency()};
+  return pool;
+}
+
+void ThreadPool::WorkerLoop() {
+  std::size_t generation{};
+
+  while (true) {
+    {
+      std::unique_lock lock{mutex_};
+      wake_.wait(lock,
+                 [&]() { return stop_ || generation_ != generation; });
+      if (stop_) {
+        return;
+      }
+      generation = generation_;
+    }
+
+    RunJobs();
+
+    {
+      std::lock_guard lock{mutex_};
+      if (--pending_ == 0) {
+        done_.notify_one();
+      }
+    }
+  }
+}
+
+void ThreadPool::RunJobs() {
+  for (std::size_t i = next_.fetch_add(1, std::memory_order_relaxed);
+       i < count_; i = next_.fetch_add(1, std::memory_order_relaxed)) {
+    (*job_)(i);
+  }
+}
+}  // namespace softy
\ No newline at end of file
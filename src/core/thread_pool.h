@@ -0,0 +1,72 @@
+#ifndef CORE_THREAD_POOL_H_
+#define CORE_THREAD_POOL_H_
+
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace softy {
+class ThreadPool {
+ public:
+  // Non-owning reference to a callable taking a job index. Unlike
+  // std::function it never allocates, whatever the lambda captures.
+  class Job {
+   public:
+    template <typename F>
+      requires(!std::same_as<std::remove_cvref_t<F>, Job> &&
+               std::invocable<F&, std::size_t>)
+    Job(F&& f) noexcept
+        : callable_{const_cast<void*>(
+              static_cast<const void*>(std::addressof(f)))},
+          invoke_{[](void* callable, std::size_t i) {
+            (*static_cast<std::remove_reference_t<F>*>(callable))(i);
+          }} {}
+
+    void operator()(std::size_t i) const { invoke_(callable_, i); }
+
+   private:
+    void* callable_;
+    void (*invoke_)(void*, std::size_t);
+  };
+
+  explicit ThreadPool(std::size_t threadCount);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ThreadPool(ThreadPool&&) = delete;
+  ThreadPool& operator=(ThreadPool&&) = delete;
+
+  // Worker threads plus the calling thread, which also runs jobs.
+  std::size_t GetThreadCount() const noexcept { return workers_.size() + 1; }
+
+  // Runs job(i) for every i in [0, count) and returns once all are done. The
+  // callable job refers to must outlive the call.
+  void ParallelFor(std::size_t count, const Job& job);
+
+  static ThreadPool& Instance();
+
+ private:
+  void WorkerLoop();
+  void RunJobs();
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+
+  const Job* job_{nullptr};
+  std::size_t count_{};
+  std::atomic<std::size_t> next_{};
+  std::size_t pending_{};
+  std::size_t generation_{};
+  bool stop_{false};
+};
+}  // namespace softy
+
+#endif  // CORE_THREAD_POOL_H_
\ No newline at end of file
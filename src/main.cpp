@@ -32,20 +32,25 @@ int32_t main([[maybe_unused]] int32_t argc, [[maybe_unused]] char** argv) {
       .name = "softy",
       .width = 800,
       .height = 600,
+      .bufferWidth = 640,
+      .bufferHeight = 480,
+      .bufferLayout = softy::BufferLayout::Tiled,
   };
   softy::Window window{};
 
   softy::ConstantBuffer cb{};
-  softy::ColorBuffer rt{640, 480};
-  softy::DepthBuffer db{640, 480};
+  softy::DepthBuffer db{640, 480, softy::BufferLayout::Tiled};
   std::unique_ptr<softy::RenderPipeline> renderPipeline(
       new softy::ForwardRenderPipeline());
 
   renderPipeline->SetConstantBuffer(&cb);
 
-  if (!window.Create(descriptor, channel, rt)) {
+  if (!window.Create(descriptor, channel)) {
     return EXIT_FAILURE;
   }
+  softy::ColorBuffer* rt = &window.GetBackBuffer();
+  rt->Clear(softy::Color::Black());
+  db.Clear(1.0f);
 
   softy::Shader shader{softy::VertexColorShader()};
   softy::Color color{0xFFFFFFFF};
@@ -56,7 +61,7 @@ int32_t main([[maybe_unused]] int32_t argc, [[maybe_unused]] char** argv) {
   cube->SetMaterial(&material);
   softy::Transform cubeTransform{};
 
-  softy::Camera cam{&rt};
+  softy::Camera cam{rt, &db};
 
   auto start = std::chrono::high_resolution_clock::now();
   while (true) {
@@ -86,9 +91,11 @@ int32_t main([[maybe_unused]] int32_t argc, [[maybe_unused]] char** argv) {
 
     renderPipeline->AddObject(cube.get(), cubeTransform.GetTRS());
     renderPipeline->Render(&cam);
-    window.Present();
+    rt = &window.Present();
+    cam.SetRenderTarget(rt);
 
-    rt.Clear(softy::Color::Black());
+    rt->Clear(softy::Color::Black());
+    db.Clear(1.0f);
   }
 
   return EXIT_SUCCESS;
@@ -103,6 +103,9 @@ constexpr auto exp(auto num) noexcept { return std::exp(num); }
 // 2^num
 constexpr auto exp2(auto num) noexcept { return std::exp2(num); }
 
+// log base 2 of num
+constexpr auto log2(auto num) noexcept { return std::log2(num); }
+
 // base^exp
 constexpr auto pow(auto base, auto exp) noexcept { return std::pow(base, exp); }
 
@@ -2,19 +2,32 @@
 
 #include <stdlib.h>
 
-#include <any>
+#include <algorithm>
+#include <bit>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <functional>
-#include <string>
-#include <unordered_map>
+#include <mutex>
+#include <new>
+#include <span>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
 
 #include "math/math.h"
 #include "math/matrix.h"
 #include "math/vector.h"
 #include "render/color.h"
+#include "render/property_block.h"
 #include "render/vertex.h"
 
 namespace softy {
@@ -79,97 +92,286 @@ bool CohenSutherlandClip(v2i& v0, v2i& v1, v2i min, v2i max) {
   return true;
 }
 
-Buffer::Buffer(std::size_t bits, std::size_t size) { Allocate(bits, size); }
+static std::size_t GetTileCount(int32_t width, int32_t height) {
+  int32_t tileCountX = (width + TileSize - 1) / TileSize;
+  int32_t tileCountY = (height + TileSize - 1) / TileSize;
+  return static_cast<std::size_t>(tileCountX * tileCountY);
+}
 
-Buffer::~Buffer() {
-  if (data_ != nullptr) {
-    free(data_);
-    data_ = nullptr;
-    size_ = 0uz;
-    capacity_ = 0uz;
+// Tiled buffers pad the edge tiles out to whole tiles.
+static std::size_t GetPixelCount(BufferLayout layout, int32_t width,
+                                 int32_t height) {
+  if (layout == BufferLayout::Linear) {
+    return static_cast<std::size_t>(width * height);
   }
+  return GetTileCount(width, height) * TileSize * TileSize;
 }
 
-Buffer::Buffer(const Buffer& buffer) {
-  assert(buffer.data_ != nullptr);
-  data_ = malloc(buffer.capacity_);
-  if (data_) {
-    size_ = buffer.size_;
-    capacity_ = buffer.capacity_;
-    memcpy(data_, buffer.data_, buffer.capacity_);
+static void FillTile(uint32_t* data, BufferLayout layout, int32_t width,
+                     int32_t height, std::size_t tile, uint32_t value) {
+  if (layout == BufferLayout::Tiled) {
+    std::fill_n(data + tile * TileSize * TileSize, TileSize * TileSize, value);
+    return;
+  }
+
+  int32_t tileCountX = (width + TileSize - 1) / TileSize;
+  auto index = static_cast<int32_t>(tile);
+  int32_t xMin = index % tileCountX * TileSize;
+  int32_t yMin = index / tileCountX * TileSize;
+  int32_t xMax = min(xMin + TileSize, width);
+  int32_t yMax = min(yMin + TileSize, height);
+  for (int32_t y = yMin; y < yMax; ++y) {
+    std::fill(data + y * width + xMin, data + y * width + xMax, value);
+  }
+}
+
+// Non-temporal stores skip reading the lines into the cache first, and a
+// full clear would only evict the working set of whatever runs next.
+void StreamFill(uint32_t* data, std::size_t count, uint32_t value) {
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  for (; i < count && reinterpret_cast<uintptr_t>(data + i) % 16 != 0; ++i) {
+    data[i] = value;
+  }
+  __m128i v = _mm_set1_epi32(static_cast<int32_t>(value));
+  for (; i + 4 <= count; i += 4) {
+    _mm_stream_si128(reinterpret_cast<__m128i*>(data + i), v);
+  }
+  _mm_sfence();
+#endif
+  for (; i < count; ++i) {
+    data[i] = value;
+  }
+}
+
+// Writes value to every tile flagged in pendingClears, in one streaming pass
+// when all of them are.
+static void ResolveClears(uint32_t* data, BufferLayout layout, int32_t width,
+                          int32_t height, std::vector<uint8_t>& pendingClears,
+                          uint32_t value) {
+  if (std::ranges::all_of(pendingClears, [](uint8_t p) { return p != 0; })) {
+    StreamFill(data, GetPixelCount(layout, width, height), value);
+  } else {
+    for (std::size_t tile = 0; tile < pendingClears.size(); ++tile) {
+      if (pendingClears[tile] != 0) {
+        FillTile(data, layout, width, height, tile, value);
+      }
+    }
+  }
+  std::ranges::fill(pendingClears, 0);
+}
+
+template <typename T>
+static void ReadLinear(const T* data, BufferLayout layout, int32_t width,
+                       int32_t height, std::span<T> pixels) {
+  assert(pixels.size() >= static_cast<std::size_t>(width * height));
+  if (layout == BufferLayout::Linear) {
+    std::copy_n(data, width * height, pixels.data());
+    return;
+  }
+
+  for (int32_t by = 0; by < height; by += BlockSize) {
+    for (int32_t bx = 0; bx < width; bx += BlockSize) {
+      const T* block = data + GetPixelIndex(layout, width, bx, by);
+      int32_t count = min(BlockSize, width - bx);
+      for (int32_t y = by; y < min(by + BlockSize, height); ++y) {
+        std::copy_n(block + (y - by) * BlockSize, count,
+                    pixels.data() + y * width + bx);
+      }
+    }
+  }
+}
+
+// Rounds bytes up to one of four size classes per power of two, so a block
+// is never more than a quarter larger than asked for.
+static std::size_t GetSizeClass(std::size_t bytes, std::size_t alignment) {
+  std::size_t capacity = CacheLineSize;
+  if (bytes > capacity) {
+    std::size_t step = 1uz << (std::bit_width(bytes - 1uz) - 3);
+    capacity = (bytes + step - 1uz) & ~(step - 1uz);
+  }
+  return (capacity + alignment - 1uz) & ~(alignment - 1uz);
+}
+
+// Freed blocks by capacity and alignment. It is never destroyed, so buffers
+// with static storage duration can still return their blocks at exit.
+class BufferPool {
+ public:
+  void* Acquire(std::size_t capacity, std::size_t alignment) {
+    {
+      std::lock_guard lock{mutex_};
+      auto it = std::ranges::find_if(free_, [&](const Block& block) {
+        return block.capacity == capacity && block.alignment == alignment;
+      });
+      if (it != free_.end()) {
+        void* data = it->data;
+        freeBytes_ -= it->capacity;
+        free_.erase(it);
+        return data;
+      }
+    }
+
+    void* data = ::operator new(capacity, std::align_val_t{alignment},
+                                std::nothrow);
+#if defined(__linux__)
+    if (data != nullptr && alignment >= HugePageSize) {
+      madvise(data, capacity, MADV_HUGEPAGE);
+    }
+#endif
+    return data;
+  }
+
+  // Evicts the oldest blocks until both the block count and the bytes held
+  // are within budget; a block larger than the whole budget is not kept.
+  void Release(void* data, std::size_t capacity, std::size_t alignment) {
+    if (capacity > MaxPooledBytes) {
+      ::operator delete(data, std::align_val_t{alignment});
+      return;
+    }
+
+    std::lock_guard lock{mutex_};
+    free_.push_back(
+        Block{.data = data, .capacity = capacity, .alignment = alignment});
+    freeBytes_ += capacity;
+    std::size_t evicted = 0;
+    while (free_.size() - evicted > MaxFreeBlocks ||
+           freeBytes_ > MaxPooledBytes) {
+      const Block& block = free_[evicted++];
+      freeBytes_ -= block.capacity;
+      ::operator delete(block.data, std::align_val_t{block.alignment});
+    }
+    free_.erase(free_.begin(), free_.begin() + evicted);
+  }
+
+  static BufferPool& Instance() {
+    static BufferPool* pool = new BufferPool();
+    return *pool;
   }
+
+ private:
+  static constexpr std::size_t MaxFreeBlocks = 32;
+
+  struct Block {
+    void* data;
+    std::size_t capacity;
+    std::size_t alignment;
+  };
+
+  std::mutex mutex_;
+  std::vector<Block> free_;
+  std::size_t freeBytes_ = 0;
+};
+
+// Render targets that span huge pages are aligned to them.
+static std::size_t GetTargetAlignment(std::size_t bits, std::size_t size) {
+  return bits * size / 8uz >= HugePageSize ? HugePageSize : CacheLineSize;
 }
 
+Buffer::Buffer(std::size_t bits, std::size_t size, std::size_t alignment) {
+  Allocate(bits, size, alignment);
+}
+
+Buffer::~Buffer() { Release(); }
+
+Buffer::Buffer(const Buffer& buffer) { *this = buffer; }
+
 Buffer& Buffer::operator=(const Buffer& buffer) {
-  assert(buffer.data_ != nullptr);
-  data_ = malloc(buffer.capacity_);
+  if (this == &buffer) {
+    return *this;
+  }
+  if (buffer.data_ == nullptr) {
+    Release();
+    return *this;
+  }
+
+  Allocate(buffer.bits_, buffer.size_, buffer.alignment_);
   if (data_) {
-    size_ = buffer.size_;
-    capacity_ = buffer.capacity_;
-    memcpy(data_, buffer.data_, buffer.capacity_);
+    memcpy(data_, buffer.data_, (bits_ * size_ + 7uz) / 8uz);
   }
   return *this;
 }
 
-Buffer::Buffer(Buffer&& buffer) {
-  data_ = buffer.data_;
-  size_ = buffer.size_;
-  capacity_ = buffer.capacity_;
-
-  buffer.data_ = nullptr;
-  buffer.size_ = 0uz;
-  buffer.capacity_ = 0uz;
-}
+Buffer::Buffer(Buffer&& buffer) noexcept { *this = std::move(buffer); }
 
-Buffer& Buffer::operator=(Buffer&& buffer) {
-  data_ = buffer.data_;
-  size_ = buffer.size_;
-  capacity_ = buffer.capacity_;
+Buffer& Buffer::operator=(Buffer&& buffer) noexcept {
+  if (this == &buffer) {
+    return *this;
+  }
 
-  buffer.data_ = nullptr;
-  buffer.size_ = 0uz;
-  buffer.capacity_ = 0uz;
+  Release();
+  data_ = std::exchange(buffer.data_, nullptr);
+  bits_ = std::exchange(buffer.bits_, 0uz);
+  size_ = std::exchange(buffer.size_, 0uz);
+  capacity_ = std::exchange(buffer.capacity_, 0uz);
+  alignment_ = std::exchange(buffer.alignment_, 0uz);
 
   return *this;
 }
 
-void Buffer::Allocate(std::size_t bits, std::size_t size) {
+void Buffer::Allocate(std::size_t bits, std::size_t size,
+                      std::size_t alignment) {
   assert(bits > 0 && size > 0);
-  std::size_t bytes = (bits * size + 7uz) / 8uz;
-  data_ = malloc(bytes);
-  if (data_) {
-    size_ = size;
-    capacity_ = bytes;
+  assert(std::has_single_bit(alignment));
+  std::size_t capacity = GetSizeClass((bits * size + 7uz) / 8uz, alignment);
+  if (data_ == nullptr || capacity != capacity_ || alignment != alignment_) {
+    Release();
+    data_ = BufferPool::Instance().Acquire(capacity, alignment);
+    if (data_ == nullptr) {
+      return;
+    }
+    capacity_ = capacity;
+    alignment_ = alignment;
   }
+  bits_ = bits;
+  size_ = size;
 }
 
-ColorBuffer::ColorBuffer(int32_t width, int32_t height)
-    : buffer_{BitCount<Color>(), static_cast<std::size_t>(width * height)},
+void Buffer::Release() noexcept {
+  if (data_ != nullptr) {
+    BufferPool::Instance().Release(data_, capacity_, alignment_);
+    data_ = nullptr;
+    bits_ = 0uz;
+    size_ = 0uz;
+    capacity_ = 0uz;
+    alignment_ = 0uz;
+  }
+}
+
+ColorBuffer::ColorBuffer(int32_t width, int32_t height, BufferLayout layout)
+    : buffer_{BitCount<Color>(), GetPixelCount(layout, width, height),
+              GetTargetAlignment(BitCount<Color>(),
+                                 GetPixelCount(layout, width, height))},
       width_{width},
-      height_{height} {}
+      height_{height},
+      layout_{layout},
+      pendingClears_(GetTileCount(width, height)) {}
 
 void ColorBuffer::SetSize(int32_t width, int32_t height) noexcept {
-  buffer_.Allocate(BitCount<Color>(), static_cast<std::size_t>(width * height));
+  std::size_t count = GetPixelCount(layout_, width, height);
+  buffer_.Allocate(BitCount<Color>(), count,
+                   GetTargetAlignment(BitCount<Color>(), count));
   width_ = width;
   height_ = height;
+  pendingClears_.assign(GetTileCount(width, height), 0);
 }
 
 Color ColorBuffer::GetPixel(int32_t x, int32_t y) {
-  assert(x > 0 && x <= width_ && y > 0 && y < height_);
+  assert(x >= 0 && x < width_ && y >= 0 && y < height_);
   Color* colors = buffer_.Get<Color>();
-  return colors[y * width_ + x];
+  return colors[GetPixelIndex(layout_, width_, x, y)];
 }
 
 void ColorBuffer::SetPixel(int32_t x, int32_t y, Color color) {
   assert(x >= 0 && x < width_ && y >= 0 && y < height_);
   Color* colors = buffer_.Get<Color>();
-  colors[y * width_ + x] = color;
+  colors[GetPixelIndex(layout_, width_, x, y)] = color;
 }
 
 void ColorBuffer::DrawLine(v2i v0, v2i v1, Color color) {
   if (!CohenSutherlandClip(v0, v1, v2i::Zero(), v2i{width_ - 1, height_ - 1})) {
     return;
   }
+  Resolve();
 
   assert(v0[0] >= 0 && v0[0] < width_ && v0[1] >= 0 && v0[1] < height_ &&
          v1[0] >= 0 && v1[0] < width_ && v1[1] >= 0 && v1[1] < height_);
@@ -202,35 +404,81 @@ void ColorBuffer::DrawLine(v2i v0, v2i v1, Color color) {
 }
 
 void ColorBuffer::Clear(Color color) {
-  Color* pixels = reinterpret_cast<Color*>(buffer_.Get());
-  std::size_t n = static_cast<std::size_t>(GetWidth() * GetHeight());
+  clearColor_ = color;
+  std::ranges::fill(pendingClears_, 1);
+}
 
-  for (int i = 0; i < n; ++i) {
-    pixels[i] = color;
+void ColorBuffer::ResolveTile(std::size_t tile) {
+  assert(tile < pendingClears_.size());
+  if (pendingClears_[tile] != 0) {
+    FillTile(buffer_.Get<uint32_t>(), layout_, width_, height_, tile,
+             clearColor_.argb);
+    pendingClears_[tile] = 0;
   }
 }
 
-DepthBuffer::DepthBuffer(int32_t width, int32_t height)
-    : buffer_{BitCount<float>(), static_cast<std::size_t>(width * height)},
+void ColorBuffer::Resolve() {
+  ResolveClears(buffer_.Get<uint32_t>(), layout_, width_, height_,
+                pendingClears_, clearColor_.argb);
+}
+
+void ColorBuffer::ReadPixels(std::span<Color> pixels) {
+  Resolve();
+  ReadLinear(buffer_.Get<Color>(), layout_, width_, height_, pixels);
+}
+
+DepthBuffer::DepthBuffer(int32_t width, int32_t height, BufferLayout layout)
+    : buffer_{BitCount<float>(), GetPixelCount(layout, width, height),
+              GetTargetAlignment(BitCount<float>(),
+                                 GetPixelCount(layout, width, height))},
       width_{width},
-      height_{height} {}
+      height_{height},
+      layout_{layout},
+      pendingClears_(GetTileCount(width, height)) {}
 
 void DepthBuffer::SetSize(int32_t width, int32_t height) noexcept {
-  buffer_.Allocate(BitCount<float>(), static_cast<std::size_t>(width * height));
+  std::size_t count = GetPixelCount(layout_, width, height);
+  buffer_.Allocate(BitCount<float>(), count,
+                   GetTargetAlignment(BitCount<float>(), count));
   width_ = width;
   height_ = height;
+  pendingClears_.assign(GetTileCount(width, height), 0);
 }
 
 float DepthBuffer::GetDepth(int32_t x, int32_t y) {
-  assert(x >= 0 && x < width_ && y > 0 && y < height_);
+  assert(x >= 0 && x < width_ && y >= 0 && y < height_);
   float* depths = buffer_.Get<float>();
-  return depths[y * width_ + x];
+  return depths[GetPixelIndex(layout_, width_, x, y)];
 }
 
 void DepthBuffer::SetDepth(int32_t x, int32_t y, float depth) {
   assert(x >= 0 && x < width_ && y >= 0 && y < height_);
   float* depths = buffer_.Get<float>();
-  depths[y * width_ + x] = depth;
+  depths[GetPixelIndex(layout_, width_, x, y)] = depth;
+}
+
+void DepthBuffer::Clear(float depth) {
+  clearDepth_ = depth;
+  std::ranges::fill(pendingClears_, 1);
+}
+
+void DepthBuffer::ResolveTile(std::size_t tile) {
+  assert(tile < pendingClears_.size());
+  if (pendingClears_[tile] != 0) {
+    FillTile(buffer_.Get<uint32_t>(), layout_, width_, height_, tile,
+             std::bit_cast<uint32_t>(clearDepth_));
+    pendingClears_[tile] = 0;
+  }
+}
+
+void DepthBuffer::Resolve() {
+  ResolveClears(buffer_.Get<uint32_t>(), layout_, width_, height_,
+                pendingClears_, std::bit_cast<uint32_t>(clearDepth_));
+}
+
+void DepthBuffer::ReadDepths(std::span<float> depths) {
+  Resolve();
+  ReadLinear(buffer_.Get<float>(), layout_, width_, height_, depths);
 }
 
 ConstantBuffer::ConstantBuffer()
@@ -260,29 +508,27 @@ void ConstantBuffer::SetProjectionMatrix(mat4 matProjection) noexcept {
   cbd->matProjection = matProjection;
 }
 
-void ConstantBuffer::SetProperties(
-    const std::unordered_map<std::string, std::any>* properties) {
+void ConstantBuffer::SetProperties(const PropertyBlock* properties) {
   ConstantBufferData* cbd = Get();
   cbd->properties = properties;
 }
 
-mat4 ConstantBuffer::GetWorldMatrix() const noexcept {
+const mat4& ConstantBuffer::GetWorldMatrix() const noexcept {
   const ConstantBufferData* cbd = Get();
   return cbd->matWorld;
 }
 
-mat4 ConstantBuffer::GetViewMatrix() const noexcept {
+const mat4& ConstantBuffer::GetViewMatrix() const noexcept {
   const ConstantBufferData* cbd = Get();
   return cbd->matView;
 }
 
-mat4 ConstantBuffer::GetProjectionMatrix() const noexcept {
+const mat4& ConstantBuffer::GetProjectionMatrix() const noexcept {
   const ConstantBufferData* cbd = Get();
   return cbd->matProjection;
 }
 
-const std::unordered_map<std::string, std::any>* ConstantBuffer::GetProperties()
-    const noexcept {
+const PropertyBlock* ConstantBuffer::GetProperties() const noexcept {
   const ConstantBufferData* cbd = Get();
   return cbd->properties;
 }
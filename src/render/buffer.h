@@ -1,30 +1,89 @@
 #ifndef RENDER_BUFFER_H_
 #define RENDER_BUFFER_H_
 
-#include <any>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
-#include <string>
-#include <unordered_map>
+#include <span>
+#include <vector>
 
 #include "math/matrix.h"
 #include "math/vector.h"
 #include "render/color.h"
+#include "render/coverage.h"
+#include "render/property_block.h"
 #include "render/vertex.h"
 
 namespace softy {
+// Screen-space tile edge length. Render targets track clears per tile and the
+// rasterizer bins triangles into tiles of the same size.
+inline constexpr int32_t TileSize = 64;
+
+// Pixel order of a render target. Tiled stores each tile contiguously as
+// row-major BlockSize x BlockSize blocks, so a coverage block's pixels share
+// four cache lines instead of spanning BlockSize rows of the image.
+enum class BufferLayout : uint8_t {
+  Linear,
+  Tiled,
+};
+
+constexpr std::size_t GetPixelIndex(BufferLayout layout, int32_t width,
+                                    int32_t x, int32_t y) {
+  if (layout == BufferLayout::Linear) {
+    return static_cast<std::size_t>(y * width + x);
+  }
+
+  int32_t tileCountX = (width + TileSize - 1) / TileSize;
+  int32_t tile = y / TileSize * tileCountX + x / TileSize;
+  int32_t block = y % TileSize / BlockSize * (TileSize / BlockSize) +
+                  x % TileSize / BlockSize;
+  return static_cast<std::size_t>(
+      (tile * (TileSize / BlockSize) * (TileSize / BlockSize) + block) *
+          BlockSize * BlockSize +
+      y % BlockSize * BlockSize + x % BlockSize);
+}
+
+// A BlockSize x BlockSize block of a render target; pixel (x, y) of it is at
+// data[y * stride + x].
+template <typename T>
+struct PixelBlock {
+  T& operator()(int32_t x, int32_t y) const noexcept {
+    return data[y * stride + x];
+  }
+
+  T* data;
+  int32_t stride;
+};
+
+inline constexpr std::size_t CacheLineSize = 64;
+// Blocks aligned to this are advised to be backed by huge pages where the OS
+// supports it.
+inline constexpr std::size_t HugePageSize = 2uz << 20;
+// Most bytes the pool keeps in freed blocks.
+inline constexpr std::size_t MaxPooledBytes = 128uz << 20;
+
+// Writes value to count elements with non-temporal stores, for clearing
+// targets too large to stay in the cache anyway.
+void StreamFill(uint32_t* data, std::size_t count, uint32_t value);
+
+// Memory of size elements of bits bits each. Blocks come from a process-wide
+// pool of size classes, so resizing reuses freed blocks instead of going back
+// to the heap.
 class Buffer {
  public:
   Buffer() = default;
-  Buffer(std::size_t bits, std::size_t size);
+  Buffer(std::size_t bits, std::size_t size,
+         std::size_t alignment = CacheLineSize);
   ~Buffer();
   Buffer(const Buffer& buffer);
   Buffer& operator=(const Buffer& buffer);
-  Buffer(Buffer&& buffer);
-  Buffer& operator=(Buffer&& buffer);
+  Buffer(Buffer&& buffer) noexcept;
+  Buffer& operator=(Buffer&& buffer) noexcept;
 
-  void Allocate(std::size_t bits, std::size_t size);
+  // Keeps the current block when it is of the same size class and
+  // alignment; its contents are undefined either way.
+  void Allocate(std::size_t bits, std::size_t size,
+                std::size_t alignment = CacheLineSize);
 
   const void* Get() const noexcept { return data_; }
   void* Get() noexcept { return data_; }
@@ -34,18 +93,23 @@ class Buffer {
   }
 
   std::size_t GetCapacity() const noexcept { return capacity_; }
+  std::size_t GetAlignment() const noexcept { return alignment_; }
 
  private:
+  void Release() noexcept;
+
   void* data_ = nullptr;
   std::size_t bits_{};
   std::size_t size_{};
   std::size_t capacity_{};
+  std::size_t alignment_{};
 };
 
 class ColorBuffer {
  public:
   ColorBuffer() = default;
-  ColorBuffer(int32_t width, int32_t height);
+  ColorBuffer(int32_t width, int32_t height,
+              BufferLayout layout = BufferLayout::Linear);
   ~ColorBuffer() = default;
 
   void SetSize(int32_t width, int32_t height) noexcept;
@@ -53,23 +117,47 @@ class ColorBuffer {
   int32_t GetWidth() const noexcept { return width_; }
   int32_t GetHeight() const noexcept { return height_; }
   int32_t GetSize() const noexcept { return width_ * height_; }
+  BufferLayout GetLayout() const noexcept { return layout_; }
   Buffer& GetData() noexcept { return buffer_; }
 
+  // (x, y) must be a multiple of BlockSize.
+  PixelBlock<Color> GetBlock(int32_t x, int32_t y) noexcept {
+    return PixelBlock<Color>{
+        .data = buffer_.Get<Color>() + GetPixelIndex(layout_, width_, x, y),
+        .stride = layout_ == BufferLayout::Tiled ? BlockSize : width_,
+    };
+  }
+
+  // Pixels of a tile with a pending clear are stale until the tile is
+  // resolved, so resolve before touching pixels or the data directly.
   Color GetPixel(int32_t x, int32_t y);
   void SetPixel(int32_t x, int32_t y, Color color);
   void DrawLine(v2i v0, v2i v1, Color color);
+
+  // Records color as the clear value of every tile without writing pixels.
   void Clear(Color color);
+  // Writes the pending clear of tile, if any. Tiles are indexed row-major in
+  // TileSize units, like the rasterizer's bins.
+  void ResolveTile(std::size_t tile);
+  // Writes every pending clear.
+  void Resolve();
+  // Resolves and copies the pixels to pixels, row-major whatever the layout.
+  void ReadPixels(std::span<Color> pixels);
 
  private:
   Buffer buffer_;
   int32_t width_{};
   int32_t height_{};
+  BufferLayout layout_{BufferLayout::Linear};
+  Color clearColor_{};
+  std::vector<uint8_t> pendingClears_;
 };
 
 class DepthBuffer {
  public:
   DepthBuffer() = default;
-  DepthBuffer(int32_t width, int32_t height);
+  DepthBuffer(int32_t width, int32_t height,
+              BufferLayout layout = BufferLayout::Linear);
   ~DepthBuffer() = default;
 
   void SetSize(int32_t width, int32_t height) noexcept;
@@ -77,22 +165,39 @@ class DepthBuffer {
   int32_t GetWidth() const noexcept { return width_; }
   int32_t GetHeight() const noexcept { return height_; }
   int32_t GetSize() const noexcept { return width_ * height_; }
+  BufferLayout GetLayout() const noexcept { return layout_; }
   Buffer& GetData() noexcept { return buffer_; }
 
+  PixelBlock<float> GetBlock(int32_t x, int32_t y) noexcept {
+    return PixelBlock<float>{
+        .data = buffer_.Get<float>() + GetPixelIndex(layout_, width_, x, y),
+        .stride = layout_ == BufferLayout::Tiled ? BlockSize : width_,
+    };
+  }
+
   float GetDepth(int32_t x, int32_t y);
   void SetDepth(int32_t x, int32_t y, float depth);
 
+  // Lazy like ColorBuffer::Clear.
+  void Clear(float depth);
+  void ResolveTile(std::size_t tile);
+  void Resolve();
+  void ReadDepths(std::span<float> depths);
+
  private:
   Buffer buffer_;
   int32_t width_{};
   int32_t height_{};
+  BufferLayout layout_{BufferLayout::Linear};
+  float clearDepth_{};
+  std::vector<uint8_t> pendingClears_;
 };
 
 struct ConstantBufferData {
   mat4 matWorld;
   mat4 matView;
   mat4 matProjection;
-  const std::unordered_map<std::string, std::any>* properties;
+  const PropertyBlock* properties;
 };
 
 class ConstantBuffer {
@@ -105,14 +210,12 @@ class ConstantBuffer {
   void SetWorldMatrix(mat4 matWorld) noexcept;
   void SetViewMatrix(mat4 matView) noexcept;
   void SetProjectionMatrix(mat4 matProjection) noexcept;
-  void SetProperties(
-      const std::unordered_map<std::string, std::any>* properties);
-
-  mat4 GetWorldMatrix() const noexcept;
-  mat4 GetViewMatrix() const noexcept;
-  mat4 GetProjectionMatrix() const noexcept;
-  const std::unordered_map<std::string, std::any>* GetProperties()
-      const noexcept;
+  void SetProperties(const PropertyBlock* properties);
+
+  const mat4& GetWorldMatrix() const noexcept;
+  const mat4& GetViewMatrix() const noexcept;
+  const mat4& GetProjectionMatrix() const noexcept;
+  const PropertyBlock* GetProperties() const noexcept;
 
  private:
   const ConstantBufferData* Get() const noexcept;
@@ -8,17 +8,23 @@
 namespace softy {
 class Camera {
  public:
-  Camera(ColorBuffer* renderTarget) : renderTarget_{renderTarget} {}
+  Camera(ColorBuffer* renderTarget, DepthBuffer* depthTarget = nullptr)
+      : renderTarget_{renderTarget}, depthTarget_{depthTarget} {}
 
   float GetAspect() const noexcept;
   mat4 GetViewMatrix() const noexcept;
   mat4 GetProjectionMatrix() const noexcept;
   ColorBuffer* GetRenderTarget() const noexcept { return renderTarget_; }
+  void SetRenderTarget(ColorBuffer* renderTarget) noexcept {
+    renderTarget_ = renderTarget;
+  }
+  DepthBuffer* GetDepthTarget() const noexcept { return depthTarget_; }
   Transform& GetTransform() noexcept { return transform_; }
 
  private:
   Transform transform_;
   ColorBuffer* renderTarget_{nullptr};
+  DepthBuffer* depthTarget_{nullptr};
   float far_{1000.0f};
   float near_{1.0f};
   float fov_{60.0f};
@@ -0,0 +1,137 @@
+#include "render/clipper.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+#include "math/math.h"
+#include "math/vector.h"
+#include "render/vertex.h"
+
+namespace softy {
+// Positive inside the plane, negative outside.
+static float PlaneDistance(v4f v, HomogeneousPlane plane, v2f guardBand) {
+  switch (plane) {
+    case HomogeneousPlane::PositiveW:
+      return v[3] - std::numeric_limits<float>::epsilon();
+    case HomogeneousPlane::PositiveX:
+      return v[3] * guardBand[0] - v[0];
+    case HomogeneousPlane::NegativeX:
+      return v[3] * guardBand[0] + v[0];
+    case HomogeneousPlane::PositiveY:
+      return v[3] * guardBand[1] - v[1];
+    case HomogeneousPlane::NegativeY:
+      return v[3] * guardBand[1] + v[1];
+    case HomogeneousPlane::PositiveZ:
+      return v[3] - v[2];
+    case HomogeneousPlane::NegativeZ:
+      return v[3] + v[2];
+    default:
+      assert(false);
+      return 0.0f;
+  }
+}
+
+Outcode ComputeOutcode(v4f position, v2f guardBand) {
+  Outcode code{};
+  for (std::size_t i = 0; i < ClipPlaneCount; ++i) {
+    auto plane = static_cast<HomogeneousPlane>(i);
+    if (PlaneDistance(position, plane, guardBand) < 0.0f) {
+      code |= 1u << i;
+    }
+  }
+
+  const float w = position[3];
+  code |= static_cast<Outcode>(position[0] > w) << (ClipPlaneCount + 0);
+  code |= static_cast<Outcode>(position[0] < -w) << (ClipPlaneCount + 1);
+  code |= static_cast<Outcode>(position[1] > w) << (ClipPlaneCount + 2);
+  code |= static_cast<Outcode>(position[1] < -w) << (ClipPlaneCount + 3);
+  return code;
+}
+
+// Returns false when polygon is already full, which only round-off in the
+// plane distances can cause.
+static bool Append(ClipPolygon& polygon, const VertexOutput& v,
+                   const UserVaryings& user, VaryingMask mask) {
+  if (polygon.size == polygon.vertices.size()) {
+    return false;
+  }
+  if (mask & varyings::User) {
+    polygon.user[polygon.size] = user;
+  }
+  polygon.vertices[polygon.size++] = v;
+  return true;
+}
+
+void ClipTriangle(const VertexOutput& v0, const VertexOutput& v1,
+                  const VertexOutput& v2,
+                  std::array<const UserVaryings*, 3> user, Outcode planes,
+                  v2f guardBand, VaryingMask mask, ClipPolygon& polygon) {
+  ClipPolygon scratch;
+  ClipPolygon* input = &polygon;
+  ClipPolygon* output = &scratch;
+
+  polygon.vertices[0] = v0;
+  polygon.vertices[1] = v1;
+  polygon.vertices[2] = v2;
+  if (mask & varyings::User) {
+    for (std::size_t i = 0; i < 3; ++i) {
+      polygon.user[i] = *user[i];
+    }
+  }
+  polygon.size = 3;
+
+  for (planes &= ClipPlaneMask; planes != 0; planes &= planes - 1) {
+    auto plane = static_cast<HomogeneousPlane>(std::countr_zero(planes));
+    output->size = 0;
+
+    const VertexOutput* prev = &input->vertices[input->size - 1];
+    const UserVaryings* prevUser = &input->user[input->size - 1];
+    float prevDistance = PlaneDistance(prev->position, plane, guardBand);
+    for (std::size_t i = 0; i < input->size; ++i) {
+      const VertexOutput* cur = &input->vertices[i];
+      const UserVaryings* curUser = &input->user[i];
+      float curDistance = PlaneDistance(cur->position, plane, guardBand);
+
+      if ((prevDistance >= 0.0f) != (curDistance >= 0.0f)) {
+        float t = prevDistance / (prevDistance - curDistance);
+        UserVaryings clipped{};
+        if (mask & varyings::User) {
+          clipped = lerp(*prevUser, *curUser, t, mask);
+        }
+        if (!Append(*output, lerp(*prev, *cur, t, mask), clipped, mask)) {
+          polygon.size = 0;
+          return;
+        }
+      }
+
+      if (curDistance >= 0.0f && !Append(*output, *cur, *curUser, mask)) {
+        polygon.size = 0;
+        return;
+      }
+
+      prev = cur;
+      prevUser = curUser;
+      prevDistance = curDistance;
+    }
+
+    std::swap(input, output);
+    if (input->size < 3) {
+      break;
+    }
+  }
+
+  if (input != &polygon) {
+    std::copy_n(input->vertices.begin(), input->size, polygon.vertices.begin());
+    if (mask & varyings::User) {
+      std::copy_n(input->user.begin(), input->size, polygon.user.begin());
+    }
+    polygon.size = input->size;
+  }
+}
+}  // namespace softy
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef RENDER_CLIPPER_H_
+#define RENDER_CLIPPER_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "math/vector.h"
+#include "render/vertex.h"
+
+namespace softy {
+enum class HomogeneousPlane : uint8_t {
+  PositiveW,
+  PositiveX,
+  NegativeX,
+  PositiveY,
+  NegativeY,
+  PositiveZ,
+  NegativeZ,
+  Count,
+};
+
+inline constexpr std::size_t ClipPlaneCount =
+    static_cast<std::size_t>(HomogeneousPlane::Count);
+
+// One bit per plane a vertex lies outside of. The low bits are the clip
+// planes, whose x and y planes sit at the guard band. The high bits are the
+// x and y planes of the view volume, which are only used for rejection.
+using Outcode = uint32_t;
+
+inline constexpr Outcode ClipPlaneMask = (1u << ClipPlaneCount) - 1u;
+inline constexpr Outcode RejectMask =
+    (1u << static_cast<uint32_t>(HomogeneousPlane::PositiveW)) |
+    (1u << static_cast<uint32_t>(HomogeneousPlane::PositiveZ)) |
+    (1u << static_cast<uint32_t>(HomogeneousPlane::NegativeZ)) |
+    (0xFu << ClipPlaneCount);
+
+// guardBand holds the guard band's half extents as multiples of w.
+Outcode ComputeOutcode(v4f position, v2f guardBand);
+
+// A triangle clipped by every plane has at most one extra vertex per plane.
+// user is only written when the clipped varyings include user varyings.
+struct ClipPolygon {
+  std::array<VertexOutput, 3 + ClipPlaneCount> vertices;
+  std::array<UserVaryings, 3 + ClipPlaneCount> user;
+  std::size_t size;
+};
+
+// Triangles the fan of a fully clipped polygon splits into.
+inline constexpr std::size_t MaxClippedTriangles = 1 + ClipPlaneCount;
+
+// Clips a triangle against the clip planes set in planes. New vertices only
+// carry the varyings in mask. user holds the user varyings of v0, v1 and v2
+// and is only read when mask has some. The result has fewer than three
+// vertices when nothing is left, or when round-off would overflow the
+// polygon.
+void ClipTriangle(const VertexOutput& v0, const VertexOutput& v1,
+                  const VertexOutput& v2,
+                  std::array<const UserVaryings*, 3> user, Outcode planes,
+                  v2f guardBand, VaryingMask mask, ClipPolygon& polygon);
+}  // namespace softy
+
+#endif  // RENDER_CLIPPER_H_
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "render/coverage.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SOFTY_X86 1
+#include <immintrin.h>
+#endif
+
+namespace softy {
+uint64_t CoverageScalar(const BlockEdges& edges) {
+  uint64_t mask{};
+  std::array<int32_t, 3> row{edges.origin};
+
+  for (int32_t y = 0; y < BlockSize; ++y) {
+    std::array<int32_t, 3> w{row};
+    for (int32_t x = 0; x < BlockSize; ++x) {
+      if ((w[0] | w[1] | w[2]) >= 0) {
+        mask |= 1ull << (y * BlockSize + x);
+      }
+      for (std::size_t i = 0; i < 3; ++i) {
+        w[i] += edges.stepX[i];
+      }
+    }
+    for (std::size_t i = 0; i < 3; ++i) {
+      row[i] += edges.stepY[i];
+    }
+  }
+
+  return mask;
+}
+
+#if SOFTY_X86
+__attribute__((target("sse2"))) uint64_t CoverageSse2(
+    const BlockEdges& edges) {
+  __m128i w[3][2];
+  __m128i stepY[3];
+  for (std::size_t i = 0; i < 3; ++i) {
+    int32_t o = edges.origin[i];
+    int32_t s = edges.stepX[i];
+    w[i][0] = _mm_setr_epi32(o, o + s, o + 2 * s, o + 3 * s);
+    w[i][1] = _mm_add_epi32(w[i][0], _mm_set1_epi32(4 * s));
+    stepY[i] = _mm_set1_epi32(edges.stepY[i]);
+  }
+
+  uint64_t mask{};
+  for (int32_t y = 0; y < BlockSize; ++y) {
+    for (std::size_t half = 0; half < 2; ++half) {
+      __m128i m = _mm_or_si128(_mm_or_si128(w[0][half], w[1][half]),
+                               w[2][half]);
+      auto bits = static_cast<uint64_t>(~_mm_movemask_ps(_mm_castsi128_ps(m)) &
+                                        0xF);
+      mask |= bits << (y * BlockSize + static_cast<int32_t>(half) * 4);
+    }
+    for (std::size_t i = 0; i < 3; ++i) {
+      w[i][0] = _mm_add_epi32(w[i][0], stepY[i]);
+      w[i][1] = _mm_add_epi32(w[i][1], stepY[i]);
+    }
+  }
+
+  return mask;
+}
+
+__attribute__((target("avx2"))) uint64_t CoverageAvx2(
+    const BlockEdges& edges) {
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  __m256i w[3];
+  __m256i stepY[3];
+  for (std::size_t i = 0; i < 3; ++i) {
+    w[i] = _mm256_add_epi32(
+        _mm256_set1_epi32(edges.origin[i]),
+        _mm256_mullo_epi32(lanes, _mm256_set1_epi32(edges.stepX[i])));
+    stepY[i] = _mm256_set1_epi32(edges.stepY[i]);
+  }
+
+  uint64_t mask{};
+  for (int32_t y = 0; y < BlockSize; ++y) {
+    __m256i m = _mm256_or_si256(_mm256_or_si256(w[0], w[1]), w[2]);
+    auto bits = static_cast<uint64_t>(
+        ~_mm256_movemask_ps(_mm256_castsi256_ps(m)) & 0xFF);
+    mask |= bits << (y * BlockSize);
+    for (std::size_t i = 0; i < 3; ++i) {
+      w[i] = _mm256_add_epi32(w[i], stepY[i]);
+    }
+  }
+
+  return mask;
+}
+
+CoverageKernel GetCoverageKernel() {
+  static const CoverageKernel kernel = []() -> CoverageKernel {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      return CoverageAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+      return CoverageSse2;
+    }
+    return CoverageScalar;
+  }();
+  return kernel;
+}
+#else
+uint64_t CoverageSse2(const BlockEdges& edges) { return CoverageScalar(edges); }
+
+uint64_t CoverageAvx2(const BlockEdges& edges) { return CoverageScalar(edges); }
+
+CoverageKernel GetCoverageKernel() { return CoverageScalar; }
+#endif
+}  // namespace softy
\ No newline at end of file
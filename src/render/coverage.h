@@ -0,0 +1,47 @@
+#ifndef RENDER_COVERAGE_H_
+#define RENDER_COVERAGE_H_
+
+#include <array>
+#include <cstdint>
+
+#include "math/math.h"
+
+namespace softy {
+// Edge length of the pixel block a coverage kernel evaluates at once.
+inline constexpr int32_t BlockSize = 8;
+
+// Three edge function values at a block's first pixel and their per-pixel
+// increments. A pixel is covered when all three values are non-negative.
+struct BlockEdges {
+  std::array<int32_t, 3> origin;
+  std::array<int32_t, 3> stepX;
+  std::array<int32_t, 3> stepY;
+};
+
+// Returns the coverage of a BlockSize x BlockSize block, one bit per pixel,
+// bit (y * BlockSize + x).
+using CoverageKernel = uint64_t (*)(const BlockEdges& edges);
+
+// Mask of the pixels of a block that lie in its first width x height corner.
+constexpr uint64_t BlockMask(int32_t width, int32_t height) {
+  if (width >= BlockSize && height >= BlockSize) {
+    return ~0ull;
+  }
+
+  uint64_t row = width >= BlockSize ? 0xFFull : (1ull << width) - 1ull;
+  uint64_t mask{};
+  for (int32_t y = 0; y < min(height, BlockSize); ++y) {
+    mask |= row << (y * BlockSize);
+  }
+  return mask;
+}
+
+uint64_t CoverageScalar(const BlockEdges& edges);
+uint64_t CoverageSse2(const BlockEdges& edges);
+uint64_t CoverageAvx2(const BlockEdges& edges);
+
+// The widest kernel the running CPU supports. Resolved once.
+CoverageKernel GetCoverageKernel();
+}  // namespace softy
+
+#endif  // RENDER_COVERAGE_H_
\ No newline at end of file
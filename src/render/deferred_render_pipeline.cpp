@@ -0,0 +1,177 @@
+#include "render/deferred_render_pipeline.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ranges>
+#include <vector>
+
+#include "core/frame_arena.h"
+#include "core/thread_pool.h"
+#include "math/math.h"
+#include "math/matrix.h"
+#include "math/vector.h"
+#include "render/buffer.h"
+#include "render/camera.h"
+#include "render/color.h"
+#include "render/gbuffer.h"
+#include "render/light.h"
+#include "render/material.h"
+#include "render/mesh.h"
+#include "render/pipeline_state.h"
+
+namespace softy {
+void DeferredRenderPipeline::RenderFrame(Camera* camera) {
+  ConstantBuffer* cb = GetConstantBuffer();
+  ColorBuffer* rt = camera->GetRenderTarget();
+  DepthBuffer* db = camera->GetDepthTarget();
+  assert(db != nullptr && "Deferred rendering needs a depth target");
+
+  if (gbuffer_.GetWidth() != rt->GetWidth() ||
+      gbuffer_.GetHeight() != rt->GetHeight()) {
+    gbuffer_.SetSize(rt->GetWidth(), rt->GetHeight());
+  }
+  gbuffer_.Clear();
+
+  FrameVector<VertexOutput> vsOutputs;
+  FrameVector<UserVaryings> userOutputs;
+
+  for (auto [mesh, transform] : std::views::zip(meshes_, transforms_)) {
+    const Material* material = mesh->GetMaterial();
+    GBufferTarget target{.gbuffer = &gbuffer_,
+                         .materialId = GetMaterialId(material)};
+
+    cb->SetWorldMatrix(transform);
+    cb->SetProperties(material->GetProperties());
+    material->GetPipelineState()->DrawGeometry(
+        *cb, target, db, mesh->GetVertices(), mesh->GetIndices(), vsOutputs,
+        userOutputs);
+  }
+
+  LightingPass(rt, db);
+
+  materials_.clear();
+  materialLighting_.clear();
+}
+
+uint8_t DeferredRenderPipeline::GetMaterialId(const Material* material) {
+  for (std::size_t i = 0; i < materials_.size(); ++i) {
+    if (materials_[i] == material) {
+      return static_cast<uint8_t>(i + 1);
+    }
+  }
+
+  // Ids live in the albedo's alpha, where 0 marks the background. Once they
+  // run out, later materials share the last id and get no highlight.
+  constexpr std::size_t lastId = 0xFF;
+  if (materials_.size() + 1 >= lastId) {
+    if (materials_.size() < lastId) {
+      materials_.push_back(nullptr);
+      materialLighting_.push_back(
+          MaterialLighting{.specular = 0.0f, .shininess = 1.0f});
+    }
+    return static_cast<uint8_t>(lastId);
+  }
+
+  const PropertyLayout& layout = material->GetShader()->GetPropertyLayout();
+  std::optional<PropertySlot<float>> specular = layout.Find<float>("Specular_");
+  std::optional<PropertySlot<float>> shininess =
+      layout.Find<float>("Shininess_");
+  MaterialLighting lighting{.specular = 0.0f, .shininess = 1.0f};
+  if (specular && shininess) {
+    lighting.specular = material->GetProperties()->Get(*specular);
+    lighting.shininess = material->GetProperties()->Get(*shininess);
+  }
+
+  materials_.push_back(material);
+  materialLighting_.push_back(lighting);
+  return static_cast<uint8_t>(materials_.size());
+}
+
+void DeferredRenderPipeline::LightingPass(ColorBuffer* renderTarget,
+                                          DepthBuffer* depthTarget) {
+  const ConstantBuffer* cb = GetConstantBuffer();
+  mat4 invViewProjection =
+      Inverse(cb->GetViewMatrix() * cb->GetProjectionMatrix());
+  v3f eye{Inverse(cb->GetViewMatrix())[3]};
+
+  FrameVector<Light> lights{lights_.begin(), lights_.end()};
+  for (Light& light : lights) {
+    light.direction = -normalize(light.direction);
+  }
+
+  v3f ambient{v4f{ambient_}};
+  int32_t width = gbuffer_.GetWidth();
+  float halfWidth = static_cast<float>(width / 2);
+  float halfHeight = static_cast<float>(gbuffer_.GetHeight() / 2);
+
+  // Rows cross tile boundaries, so pending clears are written up front. Depth
+  // is only read where the G-buffer was drawn, which resolved its tiles.
+  renderTarget->Resolve();
+
+  // World positions are reconstructed from depth. Along a row only x and
+  // depth vary, so each pixel costs two multiply-adds.
+  const GBufferTexel* texels = gbuffer_.GetData().Get<GBufferTexel>();
+  ThreadPool::Instance().ParallelFor(
+      static_cast<std::size_t>(gbuffer_.GetHeight()), [&](std::size_t row) {
+        auto y = static_cast<int32_t>(row);
+        float ndcY = (static_cast<float>(y) + 0.5f) / halfHeight - 1.0f;
+        v4f rowOrigin = invViewProjection[1] * ndcY + invViewProjection[3];
+
+        for (int32_t x = 0; x < width; ++x) {
+          std::size_t index = row * static_cast<std::size_t>(width) +
+                              static_cast<std::size_t>(x);
+          GBufferTexel texel = texels[index];
+          if (texel.albedo.a == 0) {
+            continue;
+          }
+
+          const MaterialLighting& material =
+              materialLighting_[texel.albedo.a - 1u];
+          float ndcX = (static_cast<float>(x) + 0.5f) / halfWidth - 1.0f;
+          float ndcZ = depthTarget->GetDepth(x, y) * 2.0f - 1.0f;
+          v4f world = rowOrigin + invViewProjection[0] * ndcX +
+                      invViewProjection[2] * ndcZ;
+          v3f position = v3f{world} / world[3];
+          v3f normal = DecodeNormal(texel.normal);
+          v3f view = normalize(eye - position);
+
+          v3f diffuse = ambient;
+          v3f specular{};
+          for (const Light& light : lights) {
+            v3f direction = light.direction;
+            float attenuation = light.intensity;
+            if (light.type == LightType::Point) {
+              v3f d = light.position - position;
+              float distance = length(d);
+              if (distance <= 0.0f || distance >= light.range) {
+                continue;
+              }
+              direction = d / distance;
+              float falloff = 1.0f - distance / light.range;
+              attenuation *= falloff * falloff;
+            }
+
+            float nDotL = dot(normal, direction);
+            if (nDotL <= 0.0f) {
+              continue;
+            }
+
+            v3f radiance = v3f{v4f{light.color}} * attenuation;
+            diffuse += radiance * nDotL;
+            if (material.specular > 0.0f) {
+              v3f half = normalize(direction + view);
+              float nDotH = max(dot(normal, half), 0.0f);
+              specular += radiance * (material.specular *
+                                      pow(nDotH, material.shininess));
+            }
+          }
+
+          v3f albedo{v4f{texel.albedo}};
+          renderTarget->SetPixel(
+              x, y, Color{v4f{albedo * diffuse + specular, 1.0f}});
+        }
+      });
+}
+}  // namespace softy
\ No newline at end of file
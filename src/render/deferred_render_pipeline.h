@@ -0,0 +1,47 @@
+#ifndef RENDER_DEFERRED_RENDER_PIPELINE_H_
+#define RENDER_DEFERRED_RENDER_PIPELINE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "render/camera.h"
+#include "render/color.h"
+#include "render/gbuffer.h"
+#include "render/material.h"
+#include "render/render_pipeline.h"
+
+namespace softy {
+// Rasterizes all objects into a G-buffer first, then lights every covered
+// pixel once in a full-screen pass. Fragment shaders return the albedo.
+// Materials whose shader declares float properties "Specular_" and
+// "Shininess_" also get a Blinn-Phong highlight.
+class DeferredRenderPipeline : public RenderPipeline {
+ public:
+  DeferredRenderPipeline() = default;
+  virtual ~DeferredRenderPipeline() = default;
+
+  void SetAmbient(Color ambient) noexcept { ambient_ = ambient; }
+
+ protected:
+  // The camera must have a depth target.
+  virtual void RenderFrame(Camera* camera) override;
+
+ private:
+  struct MaterialLighting {
+    float specular;
+    float shininess;
+  };
+
+  uint8_t GetMaterialId(const Material* material);
+  void LightingPass(ColorBuffer* renderTarget, DepthBuffer* depthTarget);
+
+  GBuffer gbuffer_;
+  // Materials of the current frame; material id i is entry i - 1. The last
+  // entry is null once the ids overflowed.
+  std::vector<const Material*> materials_;
+  std::vector<MaterialLighting> materialLighting_;
+  Color ambient_{0xFF202020};
+};
+}  // namespace softy
+
+#endif  // RENDER_DEFERRED_RENDER_PIPELINE_H_
\ No newline at end of file
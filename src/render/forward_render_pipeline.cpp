@@ -1,41 +1,34 @@
 #include "render/forward_render_pipeline.h"
 
-#include <algorithm>
 #include <ranges>
 #include <utility>
 #include <vector>
 
+#include "core/frame_arena.h"
 #include "render/buffer.h"
 #include "render/camera.h"
 #include "render/color.h"
 #include "render/material.h"
 #include "render/mesh.h"
-#include "render/rasterizer.h"
-#include "shader/shader.h"
+#include "render/pipeline_state.h"
 
 namespace softy {
-void ForwardRenderPipeline::Render(Camera* camera) {
+void ForwardRenderPipeline::RenderFrame(Camera* camera) {
   ConstantBuffer* cb = GetConstantBuffer();
   ColorBuffer* rt = camera->GetRenderTarget();
+  DepthBuffer* db = camera->GetDepthTarget();
 
-  std::vector<VertexOutput> vsOutputs;
+  FrameVector<VertexOutput> vsOutputs;
+  FrameVector<UserVaryings> userOutputs;
 
   for (auto [mesh, transform] : std::views::zip(meshes_, transforms_)) {
-    vsOutputs.clear();
-
     const std::vector<int32_t>& indices = mesh->GetIndices();
-    const Shader* shader = mesh->GetMaterial()->GetShader();
+    const Material* material = mesh->GetMaterial();
 
     cb->SetWorldMatrix(transform);
-    cb->SetProperties(mesh->GetMaterial()->GetProperties());
-    std::ranges::transform(
-        mesh->GetVertices(), std::back_inserter(vsOutputs),
-        [&](const Vertex& v) { return shader->GetVS()(*cb, v); });
-
-    Rasterize(*cb, *rt, vsOutputs, indices, shader->GetFS());
+    cb->SetProperties(material->GetProperties());
+    material->GetPipelineState()->Draw(*cb, *rt, db, mesh->GetVertices(),
+                                       indices, vsOutputs, userOutputs);
   }
-
-  meshes_.clear();
-  transforms_.clear();
 }
 }  // namespace softy
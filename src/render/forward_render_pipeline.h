@@ -10,7 +10,8 @@ class ForwardRenderPipeline : public RenderPipeline {
   ForwardRenderPipeline() = default;
   virtual ~ForwardRenderPipeline() = default;
 
-  virtual void Render(Camera* camera) override;
+ protected:
+  virtual void RenderFrame(Camera* camera) override;
 };
 }  // namespace softy
 
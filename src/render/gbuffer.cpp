@@ -0,0 +1,82 @@
+#include "render/gbuffer.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "math/math.h"
+#include "math/vector.h"
+#include "render/buffer.h"
+#include "render/color.h"
+
+namespace softy {
+static uint32_t QuantizeSnorm16(float v) {
+  auto q = static_cast<int32_t>(clamp(v, -1.0f, 1.0f) * 32767.0f +
+                                (v < 0.0f ? -0.5f : 0.5f));
+  return static_cast<uint32_t>(q) & 0xFFFFu;
+}
+
+static float DequantizeSnorm16(uint32_t v) {
+  return static_cast<float>(static_cast<int16_t>(v)) / 32767.0f;
+}
+
+uint32_t EncodeNormal(v3f normal) {
+  float l1 = abs(normal[0]) + abs(normal[1]) + abs(normal[2]);
+  if (l1 == 0.0f) {
+    return 0;
+  }
+
+  float x = normal[0] / l1;
+  float y = normal[1] / l1;
+  // The lower hemisphere is folded over the diagonals.
+  if (normal[2] < 0.0f) {
+    float fx = (1.0f - abs(y)) * (x < 0.0f ? -1.0f : 1.0f);
+    float fy = (1.0f - abs(x)) * (y < 0.0f ? -1.0f : 1.0f);
+    x = fx;
+    y = fy;
+  }
+  return QuantizeSnorm16(x) | (QuantizeSnorm16(y) << 16);
+}
+
+v3f DecodeNormal(uint32_t normal) {
+  float x = DequantizeSnorm16(normal & 0xFFFFu);
+  float y = DequantizeSnorm16(normal >> 16);
+  float z = 1.0f - abs(x) - abs(y);
+  float t = max(-z, 0.0f);
+  x += x < 0.0f ? t : -t;
+  y += y < 0.0f ? t : -t;
+  return normalize(v3f{x, y, z});
+}
+
+GBuffer::GBuffer(int32_t width, int32_t height)
+    : buffer_{BitCount<GBufferTexel>(),
+              static_cast<std::size_t>(width * height)},
+      width_{width},
+      height_{height} {}
+
+void GBuffer::SetSize(int32_t width, int32_t height) noexcept {
+  buffer_.Allocate(BitCount<GBufferTexel>(),
+                   static_cast<std::size_t>(width * height));
+  width_ = width;
+  height_ = height;
+}
+
+GBufferTexel GBuffer::GetTexel(int32_t x, int32_t y) {
+  assert(x >= 0 && x < width_ && y >= 0 && y < height_);
+  GBufferTexel* texels = buffer_.Get<GBufferTexel>();
+  return texels[y * width_ + x];
+}
+
+void GBuffer::SetTexel(int32_t x, int32_t y, GBufferTexel texel) {
+  assert(x >= 0 && x < width_ && y >= 0 && y < height_);
+  GBufferTexel* texels = buffer_.Get<GBufferTexel>();
+  texels[y * width_ + x] = texel;
+}
+
+void GBuffer::Clear() {
+  static_assert(sizeof(GBufferTexel) % sizeof(uint32_t) == 0);
+  std::size_t n = static_cast<std::size_t>(width_ * height_);
+  StreamFill(buffer_.Get<uint32_t>(),
+             n * sizeof(GBufferTexel) / sizeof(uint32_t), 0);
+}
+}  // namespace softy
\ No newline at end of file
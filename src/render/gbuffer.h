@@ -0,0 +1,57 @@
+#ifndef RENDER_GBUFFER_H_
+#define RENDER_GBUFFER_H_
+
+#include <cstdint>
+
+#include "math/vector.h"
+#include "render/buffer.h"
+#include "render/color.h"
+
+namespace softy {
+// Octahedral encoding of a normal, 16 bits per component. The normal does
+// not need to be unit length.
+uint32_t EncodeNormal(v3f normal);
+v3f DecodeNormal(uint32_t normal);
+
+// Surface attributes of a pixel. Depth is kept in the camera's depth target.
+struct GBufferTexel {
+  uint32_t normal;
+  // Albedo in r, g and b; the material id in a. Id 0 marks empty pixels.
+  Color albedo;
+};
+
+class GBuffer {
+ public:
+  GBuffer() = default;
+  GBuffer(int32_t width, int32_t height);
+  ~GBuffer() = default;
+
+  void SetSize(int32_t width, int32_t height) noexcept;
+
+  int32_t GetWidth() const noexcept { return width_; }
+  int32_t GetHeight() const noexcept { return height_; }
+  Buffer& GetData() noexcept { return buffer_; }
+
+  GBufferTexel GetTexel(int32_t x, int32_t y);
+  void SetTexel(int32_t x, int32_t y, GBufferTexel texel);
+  // Marks every pixel empty.
+  void Clear();
+
+ private:
+  Buffer buffer_;
+  int32_t width_{};
+  int32_t height_{};
+};
+
+// Render target of a deferred geometry pass. Fragment shaders return the
+// albedo; the interpolated normal is written next to it.
+struct GBufferTarget {
+  GBuffer* gbuffer;
+  uint8_t materialId;
+
+  int32_t GetWidth() const noexcept { return gbuffer->GetWidth(); }
+  int32_t GetHeight() const noexcept { return gbuffer->GetHeight(); }
+};
+}  // namespace softy
+
+#endif  // RENDER_GBUFFER_H_
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef RENDER_LIGHT_H_
+#define RENDER_LIGHT_H_
+
+#include <cstdint>
+
+#include "math/vector.h"
+#include "render/color.h"
+
+namespace softy {
+enum class LightType : uint8_t {
+  Directional,
+  Point,
+};
+
+struct Light {
+  LightType type{LightType::Directional};
+  // World space. Directional lights use direction, the way light travels;
+  // point lights use position.
+  v3f position;
+  v3f direction{0.0f, 0.0f, 1.0f};
+  Color color{0xFFFFFFFF};
+  float intensity{1.0f};
+  // Distance at which a point light's contribution falls to zero.
+  float range{10.0f};
+};
+}  // namespace softy
+
+#endif  // RENDER_LIGHT_H_
\ No newline at end of file
@@ -1,29 +1,73 @@
 #ifndef RENDER_MATERIAL_H_
 #define RENDER_MATERIAL_H_
 
-#include <any>
-#include <string>
-#include <unordered_map>
+#include <optional>
+#include <string_view>
 
+#include "render/pipeline_state.h"
+#include "render/property_block.h"
+#include "render/render_state.h"
 #include "shader/shader.h"
 
 namespace softy {
 class Material {
  public:
-  Material(Shader* shader) : shader_{shader} {}
+  Material(Shader* shader)
+      : shader_{shader}, properties_{shader->GetPropertyLayout()} {
+    UpdatePipelineState();
+  }
 
   const Shader* GetShader() const noexcept { return shader_; }
-  const std::unordered_map<std::string, std::any>* GetProperties() const {
-    return &properties_;
+  const PropertyBlock* GetProperties() const { return &properties_; }
+
+  const DepthState& GetDepthState() const noexcept { return depthState_; }
+  CullMode GetCullMode() const noexcept { return cullMode_; }
+  BlendMode GetBlendMode() const noexcept { return blendMode_; }
+  const PipelineState* GetPipelineState() const noexcept {
+    return pipelineState_;
+  }
+
+  // Properties the shader does not declare as a T are ignored.
+  template <typename T>
+  void SetProperty(std::string_view name, const T& value) {
+    std::optional<PropertySlot<T>> slot =
+        shader_->GetPropertyLayout().Find<T>(name);
+    if (slot) {
+      properties_.Set(*slot, value);
+    }
+  }
+
+  void SetDepthState(DepthState depthState) {
+    depthState_ = depthState;
+    UpdatePipelineState();
+  }
+
+  void SetCullMode(CullMode cullMode) {
+    cullMode_ = cullMode;
+    UpdatePipelineState();
   }
 
-  void SetProperty(std::string name, std::any value) {
-    properties_[name] = value;
+  void SetBlendMode(BlendMode blendMode) {
+    blendMode_ = blendMode;
+    UpdatePipelineState();
   }
 
  private:
+  void UpdatePipelineState() {
+    pipelineState_ = PipelineStateCache::Instance().Get(PipelineStateDesc{
+        .shader = shader_,
+        .depthState = depthState_,
+        .cullMode = cullMode_,
+        .blendMode = blendMode_,
+    });
+  }
+
   Shader* shader_;
-  std::unordered_map<std::string, std::any> properties_;
+  PropertyBlock properties_;
+  DepthState depthState_;
+  CullMode cullMode_{CullMode::Back};
+  BlendMode blendMode_{BlendMode::Opaque};
+  const PipelineState* pipelineState_;
 };
 }  // namespace softy
 
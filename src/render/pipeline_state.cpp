@@ -0,0 +1,104 @@
+#include "render/pipeline_state.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "core/frame_arena.h"
+#include "render/buffer.h"
+#include "render/gbuffer.h"
+#include "render/rasterizer.h"
+#include "render/render_state.h"
+#include "render/triangle_setup.h"
+#include "render/vertex.h"
+#include "render/visibility_buffer.h"
+#include "shader/shader.h"
+
+namespace softy {
+PipelineState::PipelineState(const PipelineStateDesc& desc)
+    : desc_{desc},
+      rasterize_{desc.shader->GetRasterStage(RasterState{
+          .depth = desc.depthState,
+          .blend = desc.blendMode,
+      })},
+      drawGeometry_{desc.shader->GetGeometryStage(desc.depthState)},
+      drawVisibility_{GetVisibilityStage(desc.depthState)},
+      resolve_{desc.shader->GetResolveStage()} {}
+
+void PipelineState::Draw(const ConstantBuffer& cb, ColorBuffer& renderTarget,
+                         DepthBuffer* depthTarget,
+                         const std::vector<Vertex>& vertices,
+                         const std::vector<int>& indices,
+                         FrameVector<VertexOutput>& vsOutputs,
+                         FrameVector<UserVaryings>& userOutputs) const {
+  desc_.shader->ProcessVertices(cb, vertices, vsOutputs, userOutputs);
+  rasterize_(*desc_.shader, cb, renderTarget, depthTarget, desc_.cullMode,
+             vsOutputs, userOutputs, indices);
+}
+
+void PipelineState::DrawGeometry(const ConstantBuffer& cb,
+                                 GBufferTarget& renderTarget,
+                                 DepthBuffer* depthTarget,
+                                 const std::vector<Vertex>& vertices,
+                                 const std::vector<int>& indices,
+                                 FrameVector<VertexOutput>& vsOutputs,
+                                 FrameVector<UserVaryings>& userOutputs) const {
+  desc_.shader->ProcessVertices(cb, vertices, vsOutputs, userOutputs);
+  drawGeometry_(*desc_.shader, cb, renderTarget, depthTarget, desc_.cullMode,
+                vsOutputs, userOutputs, indices);
+}
+
+BinnedTriangles PipelineState::DrawVisibility(
+    const ConstantBuffer& cb, VisibilityTarget& renderTarget,
+    DepthBuffer* depthTarget, const std::vector<Vertex>& vertices,
+    std::span<const int32_t> indices, FrameVector<VertexOutput>& vsOutputs,
+    FrameVector<UserVaryings>& userOutputs) const {
+  desc_.shader->ProcessVertices(cb, vertices, vsOutputs, userOutputs);
+  BinnedTriangles binned =
+      BinTriangles(renderTarget.GetWidth(), renderTarget.GetHeight(),
+                   vsOutputs, userOutputs, indices,
+                   desc_.shader->GetVaryings(), desc_.cullMode);
+  drawVisibility_(renderTarget, depthTarget, binned);
+  return binned;
+}
+
+void PipelineState::Resolve(const ConstantBuffer& cb,
+                            ColorBuffer& renderTarget,
+                            const BinnedTriangles& binned,
+                            std::span<const VisibleQuad> quads) const {
+  resolve_(*desc_.shader, cb, renderTarget, binned, quads);
+}
+
+std::size_t PipelineStateCache::KeyHash::operator()(
+    const Key& key) const noexcept {
+  return std::hash<uint64_t>{}(key.shaderId) ^
+         (key.state * 0x9E3779B97F4A7C15);
+}
+
+const PipelineState* PipelineStateCache::Get(const PipelineStateDesc& desc) {
+  std::size_t index = GetRasterStateIndex(RasterState{
+      .depth = desc.depthState,
+      .blend = desc.blendMode,
+  });
+  Key key{
+      .shaderId = desc.shader->GetId(),
+      .state = index * 3 + static_cast<std::size_t>(desc.cullMode),
+  };
+
+  std::lock_guard lock{mutex_};
+  std::unique_ptr<PipelineState>& state = states_[key];
+  if (!state) {
+    state = std::make_unique<PipelineState>(desc);
+  }
+  return state.get();
+}
+
+PipelineStateCache& PipelineStateCache::Instance() {
+  static PipelineStateCache cache;
+  return cache;
+}
+}  // namespace softy
\ No newline at end of file
@@ -0,0 +1,105 @@
+#ifndef RENDER_PIPELINE_STATE_H_
+#define RENDER_PIPELINE_STATE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "core/frame_arena.h"
+#include "render/buffer.h"
+#include "render/gbuffer.h"
+#include "render/rasterizer.h"
+#include "render/render_state.h"
+#include "render/triangle_setup.h"
+#include "render/vertex.h"
+#include "render/visibility_buffer.h"
+#include "shader/shader.h"
+
+namespace softy {
+struct PipelineStateDesc {
+  const Shader* shader{nullptr};
+  DepthState depthState;
+  CullMode cullMode{CullMode::Back};
+  BlendMode blendMode{BlendMode::Opaque};
+
+  bool operator==(const PipelineStateDesc&) const = default;
+};
+
+// Draw state resolved once to the rasterizer compiled for it, so binding a
+// pipeline state costs a pointer and draws never branch on it per pixel.
+class PipelineState {
+ public:
+  explicit PipelineState(const PipelineStateDesc& desc);
+
+  const PipelineStateDesc& GetDesc() const noexcept { return desc_; }
+
+  // vsOutputs and userOutputs are scratch storage reused across draws.
+  void Draw(const ConstantBuffer& cb, ColorBuffer& renderTarget,
+            DepthBuffer* depthTarget, const std::vector<Vertex>& vertices,
+            const std::vector<int>& indices,
+            FrameVector<VertexOutput>& vsOutputs,
+            FrameVector<UserVaryings>& userOutputs) const;
+
+  // Writes the draw to a G-buffer. The blend mode does not apply.
+  void DrawGeometry(const ConstantBuffer& cb, GBufferTarget& renderTarget,
+                    DepthBuffer* depthTarget,
+                    const std::vector<Vertex>& vertices,
+                    const std::vector<int>& indices,
+                    FrameVector<VertexOutput>& vsOutputs,
+                    FrameVector<UserVaryings>& userOutputs) const;
+
+  // Writes the draw's visibility ids. The returned triangles are what the
+  // ids refer to; they are needed again to resolve the draw.
+  BinnedTriangles DrawVisibility(const ConstantBuffer& cb,
+                                 VisibilityTarget& renderTarget,
+                                 DepthBuffer* depthTarget,
+                                 const std::vector<Vertex>& vertices,
+                                 std::span<const int32_t> indices,
+                                 FrameVector<VertexOutput>& vsOutputs,
+                                 FrameVector<UserVaryings>& userOutputs) const;
+
+  // Shades quads of the draw found in a visibility buffer.
+  void Resolve(const ConstantBuffer& cb, ColorBuffer& renderTarget,
+               const BinnedTriangles& binned,
+               std::span<const VisibleQuad> quads) const;
+
+ private:
+  PipelineStateDesc desc_;
+  Shader::RasterStage rasterize_;
+  Shader::GeometryStage drawGeometry_;
+  VisibilityStage drawVisibility_;
+  Shader::ResolveStage resolve_;
+};
+
+// Owns every pipeline state created. Equal descs share one state, which
+// stays valid for the lifetime of the program.
+class PipelineStateCache {
+ public:
+  const PipelineState* Get(const PipelineStateDesc& desc);
+
+  static PipelineStateCache& Instance();
+
+ private:
+  // Shaders are keyed by id, since a later shader may reuse the address of
+  // a destroyed one.
+  struct Key {
+    uint64_t shaderId;
+    std::size_t state;
+
+    bool operator==(const Key&) const = default;
+  };
+
+  struct KeyHash {
+    std::size_t operator()(const Key& key) const noexcept;
+  };
+
+  std::mutex mutex_;
+  std::unordered_map<Key, std::unique_ptr<PipelineState>, KeyHash> states_;
+};
+}  // namespace softy
+
+#endif  // RENDER_PIPELINE_STATE_H_
\ No newline at end of file
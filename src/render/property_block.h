@@ -0,0 +1,106 @@
+#ifndef RENDER_PROPERTY_BLOCK_H_
+#define RENDER_PROPERTY_BLOCK_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "type/type_id.h"
+
+namespace softy {
+// Location of a property of type T inside a PropertyBlock.
+template <typename T>
+struct PropertySlot {
+  uint32_t offset;
+};
+
+// Names, types and offsets of the properties a shader reads. Slots are
+// resolved when the layout is built; names are only looked up when a
+// material sets a value.
+class PropertyLayout {
+ public:
+  template <typename T>
+  PropertySlot<T> Add(std::string name);
+
+  // Empty when no property is called name or its type is not T.
+  template <typename T>
+  std::optional<PropertySlot<T>> Find(std::string_view name) const;
+
+  std::size_t GetSize() const noexcept { return size_; }
+
+ private:
+  struct Entry {
+    std::string name;
+    uint32_t type;
+    uint32_t offset;
+  };
+
+  std::vector<Entry> entries_;
+  std::size_t size_{};
+};
+
+// Property values of one material, packed as described by a PropertyLayout.
+class PropertyBlock {
+ public:
+  PropertyBlock() = default;
+  explicit PropertyBlock(const PropertyLayout& layout)
+      : data_(layout.GetSize()) {}
+
+  template <typename T>
+  T Get(PropertySlot<T> slot) const;
+
+  template <typename T>
+  void Set(PropertySlot<T> slot, const T& value);
+
+ private:
+  std::vector<std::byte> data_;
+};
+
+template <typename T>
+inline PropertySlot<T> PropertyLayout::Add(std::string name) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  std::size_t offset = (size_ + alignof(T) - 1) / alignof(T) * alignof(T);
+  size_ = offset + sizeof(T);
+
+  auto slot = PropertySlot<T>{static_cast<uint32_t>(offset)};
+  entries_.push_back(Entry{std::move(name), type_id<T>::value, slot.offset});
+  return slot;
+}
+
+template <typename T>
+inline std::optional<PropertySlot<T>> PropertyLayout::Find(
+    std::string_view name) const {
+  for (const Entry& entry : entries_) {
+    if (entry.name == name) {
+      if (entry.type != type_id<T>::value) {
+        return std::nullopt;
+      }
+      return PropertySlot<T>{entry.offset};
+    }
+  }
+  return std::nullopt;
+}
+
+template <typename T>
+inline T PropertyBlock::Get(PropertySlot<T> slot) const {
+  assert(slot.offset + sizeof(T) <= data_.size());
+  T value;
+  std::memcpy(&value, data_.data() + slot.offset, sizeof(T));
+  return value;
+}
+
+template <typename T>
+inline void PropertyBlock::Set(PropertySlot<T> slot, const T& value) {
+  assert(slot.offset + sizeof(T) <= data_.size());
+  std::memcpy(data_.data() + slot.offset, &value, sizeof(T));
+}
+}  // namespace softy
+
+#endif  // RENDER_PROPERTY_BLOCK_H_
\ No newline at end of file
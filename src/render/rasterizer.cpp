@@ -1,301 +1,234 @@
 #include "render/rasterizer.h"
 
-#include <algorithm>
 #include <array>
-#include <functional>
-#include <limits>
-#include <ranges>
-
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "core/frame_arena.h"
 #include "math/math.h"
-#include "math/matrix.h"
 #include "math/vector.h"
 #include "render/buffer.h"
-#include "render/color.h"
-#include "render/material.h"
+#include "render/clipper.h"
+#include "render/render_state.h"
+#include "render/triangle_setup.h"
 #include "render/vertex.h"
-#include "shader/shader.h"
+#include "render/visibility_buffer.h"
+#include "shader/fragment.h"
 
 namespace softy {
-static bool BackfaceCulling(v2f v0, v2f v1, v2f v2) {
-  return cross(v1 - v0, v2 - v0) < 0.0f;
+static int32_t ToFixed(float v) {
+  return static_cast<int32_t>(floor(v * SubPixelOne + 0.5f));
 }
 
-static bool FrustumCulling(v4f v0, v4f v1, v4f v2) {
-  if (abs(v0[0]) > v0[3] && abs(v1[0]) > v1[3] && abs(v2[0]) > v2[3]) {
-    return true;
-  }
-
-  if (abs(v0[1]) > v0[3] && abs(v1[1]) > v1[3] && abs(v2[1]) > v2[3]) {
-    return true;
-  }
-
-  if (v0[2] > v0[3] && v1[2] > v1[3] && v2[2] > v2[3]) {
-    return true;
-  }
-
-  return false;
+static int64_t SignedArea(v2i v0, v2i v1, v2i v2) {
+  return static_cast<int64_t>(v1[0] - v0[0]) * (v2[1] - v0[1]) -
+         static_cast<int64_t>(v1[1] - v0[1]) * (v2[0] - v0[0]);
 }
 
-enum class HomogeneousPlane {
-  PositiveW,
-  PositiveX,
-  NegativeX,
-  PositiveY,
-  NegativeY,
-  PositiveZ,
-  NegativeZ,
-};
-
-static int32_t IsVisible(v4f v) {
-  return abs(v[0]) <= v[3] && abs(v[1]) <= v[3] && abs(v[2]) <= v[3];
-}
-
-static int32_t IsInisdePlane(v4f v, HomogeneousPlane plane) {
-  switch (plane) {
-    case HomogeneousPlane::PositiveW:
-      return v[3] >= std::numeric_limits<float>::epsilon();
-    case HomogeneousPlane::PositiveX:
-      return v[0] <= v[3];
-    case HomogeneousPlane::NegativeX:
-      return v[0] >= -v[3];
-    case HomogeneousPlane::PositiveY:
-      return v[1] <= v[3];
-    case HomogeneousPlane::NegativeY:
-      return v[1] >= -v[3];
-    case HomogeneousPlane::PositiveZ:
-      return v[2] <= v[3];
-    case HomogeneousPlane::NegativeZ:
-      return v[2] >= -v[3];
+// Degenerate triangles cover no pixel centers and are always culled.
+// Counter-clockwise triangles have a positive area.
+static bool IsCulled(int64_t area, CullMode cullMode) {
+  switch (cullMode) {
+    case CullMode::Back:
+      return area <= 0;
+    case CullMode::Front:
+      return area >= 0;
     default:
-      assert(false);
-      return 0;
+      return area == 0;
   }
 }
 
-static float fraction(v4f prev, v4f cur, HomogeneousPlane plane) {
-  switch (plane) {
-    case HomogeneousPlane::PositiveW:
-      return (prev[3] - std::numeric_limits<float>::epsilon()) /
-             (prev[3] - cur[3]);
-    case HomogeneousPlane::PositiveX:
-      return (prev[3] - prev[0]) / ((prev[3] - prev[0]) - (cur[3] - cur[0]));
-    case HomogeneousPlane::NegativeX:
-      return (prev[3] + prev[0]) / ((prev[3] + prev[0]) - (cur[3] + cur[0]));
-    case HomogeneousPlane::PositiveY:
-      return (prev[3] - prev[1]) / ((prev[3] - prev[1]) - (cur[3] - cur[1]));
-    case HomogeneousPlane::NegativeY:
-      return (prev[3] + prev[1]) / ((prev[3] + prev[1]) - (cur[3] + cur[1]));
-    case HomogeneousPlane::PositiveZ:
-      return (prev[3] - prev[2]) / ((prev[3] - prev[2]) - (cur[3] - cur[2]));
-    case HomogeneousPlane::NegativeZ:
-      return (prev[3] + prev[2]) / ((prev[3] + prev[2]) - (cur[3] + cur[2]));
-    default:
-      assert(false);
-      return 0;
-  }
+// Largest distance in pixels from the screen center a triangle may reach
+// without being clipped. The guard band never shrinks below the target, so
+// fixed-point edge deltas stay below 2^20 only for targets up to 4094
+// pixels across; beyond that they are bounded by the target's size times
+// SubPixelOne.
+static constexpr float GuardBandExtent = 2047.0f;
+
+static ScreenVertex ToScreen(const VertexOutput& v, v2f halfSize) {
+  ScreenVertex s{.vertex = v, .fixed = {}};
+  v4f& position = s.vertex.position;
+  float rhw = 1.0f / position[3];
+  position = position * rhw;
+  s.fixed = v2i{ToFixed(position[0] * halfSize[0] + halfSize[0]),
+                ToFixed(position[1] * halfSize[1] + halfSize[1])};
+  position[0] = static_cast<float>(s.fixed[0]) / SubPixelOne;
+  position[1] = static_cast<float>(s.fixed[1]) / SubPixelOne;
+  position[2] = position[2] * 0.5f + 0.5f;
+  position[3] = rhw;
+  return s;
 }
 
-static std::vector<VertexOutput> PlaneClipping(
-    HomogeneousPlane plane, const std::vector<VertexOutput>& inputs) {
-  if (inputs.size() < 3) {
-    return {};
+static std::optional<TriangleSetup> SetupTriangle(
+    std::span<const ScreenVertex> vertices, std::array<uint32_t, 3> index,
+    int32_t width, int32_t height, CullMode cullMode) {
+  int64_t area = SignedArea(vertices[index[0]].fixed, vertices[index[1]].fixed,
+                            vertices[index[2]].fixed);
+  if (IsCulled(area, cullMode)) {
+    return std::nullopt;
   }
 
-  std::vector<VertexOutput> outputs;
-
-  for (std::size_t i = 0; i < inputs.size(); ++i) {
-    const VertexOutput& prev = inputs[(inputs.size() + i - 1) % inputs.size()];
-    int32_t isPrevInside = IsInisdePlane(prev.position, plane);
-    const VertexOutput& cur = inputs[i];
-    int32_t isCurInside = IsInisdePlane(cur.position, plane);
-
-    if (isPrevInside != isCurInside) {
-      float f = fraction(prev.position, cur.position, plane);
-      VertexOutput out = lerp(prev, cur, f);
-      outputs.push_back(out);
-    }
-
-    if (isCurInside) {
-      outputs.push_back(cur);
-    }
+  // Edge functions assume counter-clockwise winding.
+  if (area < 0) {
+    std::swap(index[1], index[2]);
   }
 
-  if (outputs.size() < 3) {
-    return {};
+  const ScreenVertex& v0 = vertices[index[0]];
+  const ScreenVertex& v1 = vertices[index[1]];
+  const ScreenVertex& v2 = vertices[index[2]];
+
+  // Pixels whose centers lie inside the fixed-point bounding box.
+  constexpr int32_t half = SubPixelOne / 2;
+  PixelRect bounds{
+      .xMin = (min(v0.fixed[0], min(v1.fixed[0], v2.fixed[0])) + half - 1) >>
+              SubPixelBits,
+      .yMin = (min(v0.fixed[1], min(v1.fixed[1], v2.fixed[1])) + half - 1) >>
+              SubPixelBits,
+      .xMax = (max(v0.fixed[0], max(v1.fixed[0], v2.fixed[0])) - half) >>
+              SubPixelBits,
+      .yMax = (max(v0.fixed[1], max(v1.fixed[1], v2.fixed[1])) - half) >>
+              SubPixelBits,
+  };
+  bounds.xMin = max(bounds.xMin, 0);
+  bounds.yMin = max(bounds.yMin, 0);
+  bounds.xMax = min(bounds.xMax, width - 1);
+  bounds.yMax = min(bounds.yMax, height - 1);
+  if (bounds.xMin > bounds.xMax || bounds.yMin > bounds.yMax) {
+    return std::nullopt;
   }
 
-  return outputs;
+  return TriangleSetup{
+      .edges = {Edge{v0.fixed, v1.fixed}, Edge{v1.fixed, v2.fixed},
+                Edge{v2.fixed, v0.fixed}},
+      .bounds = bounds,
+      .vertices = index,
+  };
 }
 
-std::vector<VertexOutput> HomogeneousClipping(
-    std::vector<VertexOutput>& inputs) {
-  std::vector<VertexOutput> outputs;
-
-  std::vector<VertexOutput> verts;
-  for (std::size_t i = 0; i < inputs.size(); i += 3) {
-    VertexOutput& v0 = inputs[i + 0];
-    VertexOutput& v1 = inputs[i + 1];
-    VertexOutput& v2 = inputs[i + 2];
-
-    if (IsVisible(v0.position) && IsVisible(v1.position) &&
-        IsVisible(v2.position)) {
-      outputs.push_back(v0);
-      outputs.push_back(v1);
-      outputs.push_back(v2);
-      continue;
-    }
-
-    verts.push_back(v0);
-    verts.push_back(v1);
-    verts.push_back(v2);
-
-    for (int j = 0; j < 7; ++j) {
-      verts = PlaneClipping(static_cast<HomogeneousPlane>(j), verts);
-    }
-
-    for (std::size_t j = 2; j < verts.size(); ++j) {
-      VertexOutput& out0 = verts[0];
-      VertexOutput& out1 = verts[j - 1];
-      VertexOutput& out2 = verts[j - 0];
+BinnedTriangles BinTriangles(int32_t width, int32_t height,
+                             std::span<const VertexOutput> vsOutputs,
+                             std::span<const UserVaryings> user,
+                             std::span<const int32_t> indices,
+                             VaryingMask mask, CullMode cullMode) {
+  float halfWidth = static_cast<float>(width / 2);
+  float halfHeight = static_cast<float>(height / 2);
+
+  // Never narrower than the viewport, or targets wider than twice the extent
+  // would lose their edges to the clipper.
+  v2f guardBand{max(GuardBandExtent / halfWidth, 1.0f),
+                max(GuardBandExtent / halfHeight, 1.0f)};
+
+  FrameVector<Outcode> outcodes(vsOutputs.size());
+  for (std::size_t i = 0; i < vsOutputs.size(); ++i) {
+    outcodes[i] = ComputeOutcode(vsOutputs[i].position, guardBand);
+  }
 
-      outputs.push_back(out0);
-      outputs.push_back(out1);
-      outputs.push_back(out2);
+  int32_t tileCountX = (width + TileSize - 1) / TileSize;
+  int32_t tileCountY = (height + TileSize - 1) / TileSize;
+  FrameVector<FrameVector<uint32_t>> bins(
+      static_cast<std::size_t>(tileCountX * tileCountY));
+
+  FrameVector<TriangleSetup> triangles;
+  triangles.reserve(indices.size() / 3);
+
+  // Vertices inside every clip plane are projected once and shared by all
+  // triangles that reference them. Clipped vertices are appended.
+  v2f halfSize{halfWidth, halfHeight};
+  FrameVector<ScreenVertex> vertices(vsOutputs.size());
+  for (std::size_t i = 0; i < vsOutputs.size(); ++i) {
+    if ((outcodes[i] & ClipPlaneMask) == 0) {
+      vertices[i] = ToScreen(vsOutputs[i], halfSize);
     }
-
-    verts.clear();
   }
 
-  return outputs;
-}
-
-struct Edge {
-  Edge(v2i v0, v2i v1, v2i p) {
-    int32_t a = v0[1] - v1[1];
-    int32_t b = v1[0] - v0[0];
-    int32_t c = v0[0] * v1[1] - v0[1] * v1[0];
-
-    oneStepX = v4i::One() * (a * StepXSize);
-    oneStepY = v4i::One() * (b * StepYSize);
-
-    v4i x = v4i::One() * p[0] + v4i{0, 1, 2, 3};
-    v4i y = v4i::One() * p[1];
-
-    equation = (v4i::One() * a) * x + (v4i::One() * b) * y + (v4i::One() * c);
+  FrameVector<UserVaryings> screenUser;
+  bool hasUser = (mask & varyings::User) != 0;
+  if (hasUser) {
+    assert(user.size() == vsOutputs.size());
+    screenUser.assign(user.begin(), user.end());
   }
 
-  static constexpr int32_t StepXSize = 4;
-  static constexpr int32_t StepYSize = 1;
-
-  v4i oneStepX;
-  v4i oneStepY;
-
-  v4i equation;
-};
-
-static bool IsTopOrLeftEdge(v2i v0, v2i v1) {
-  v2i e = v1 - v0;
-  bool isLeft = e[1] > 0;
-  bool isTop = e[1] == 0 && e[0] < 0;
-  return isLeft | isTop;
-}
-
-static void DrawTriangle(const ConstantBuffer& constantBuffer,
-                         ColorBuffer& renderTarget, const VertexOutput& v0,
-                         const VertexOutput& v1, const VertexOutput& v2,
-                         FragmentShader fs) {
-  std::array<VertexOutput, 3> verts{v0, v1, v2};
-  std::ranges::sort(verts, [](const auto& a, const auto& b) {
-    return a.position[1] < b.position[1];
-  });
-
-  int32_t yMin = static_cast<int32_t>(
-      min(v0.position[1], min(v1.position[1], v2.position[1])));
-  int32_t yMax = static_cast<int32_t>(
-      max(v0.position[1], max(v1.position[1], v2.position[1])));
-  int32_t xMin = static_cast<int32_t>(
-      min(v0.position[0], min(v1.position[0], v2.position[0])));
-  int32_t xMax = static_cast<int32_t>(
-      max(v0.position[0], max(v1.position[0], v2.position[0])));
-
-  v2i p{xMin, yMin};
-  Edge edge0{v0.position, v1.position, p};
-  Edge edge1{v1.position, v2.position, p};
-  Edge edge2{v2.position, v0.position, p};
-
-  for (; p[1] <= yMax; p[1] += Edge::StepYSize) {
-    v4i w0{edge0.equation};
-    v4i w1{edge1.equation};
-    v4i w2{edge2.equation};
+  auto assemble = [&](uint32_t i0, uint32_t i1, uint32_t i2) {
+    std::optional<TriangleSetup> setup =
+        SetupTriangle(vertices, {i0, i1, i2}, width, height, cullMode);
+    if (!setup) {
+      return;
+    }
 
-    for (p[0] = xMin; p[0] <= xMax; p[0] += Edge::StepXSize) {
-      v4i mask{w0 | w1 | w2};
-      if (mask[0] >= 0 || mask[1] >= 0 || mask[2] >= 0 || mask[3] >= 0) {
-        for (int32_t x = 0; x < Edge::StepXSize; ++x) {
-          v3f b = barycentricCoordinate(v2f{v0.position}, v2f{v1.position},
-                                        v2f{v2.position}, v2f{p[0] + x, p[1]});
-          VertexOutput v = lerp(v0, v1, v2, b);
-          renderTarget.SetPixel(p[0] + x, p[1], fs(constantBuffer, v));
-        }
+    const PixelRect& bounds = setup->bounds;
+    auto index = static_cast<uint32_t>(triangles.size());
+    for (int32_t ty = bounds.yMin / TileSize; ty <= bounds.yMax / TileSize;
+         ++ty) {
+      for (int32_t tx = bounds.xMin / TileSize;
+           tx <= bounds.xMax / TileSize; ++tx) {
+        bins[static_cast<std::size_t>(ty * tileCountX + tx)].push_back(index);
       }
-
-      w0 += edge0.oneStepX;
-      w1 += edge1.oneStepX;
-      w2 += edge2.oneStepX;
     }
+    triangles.push_back(*setup);
+  };
 
-    edge0.equation += edge0.oneStepY;
-    edge1.equation += edge1.oneStepY;
-    edge2.equation += edge2.oneStepY;
-  }
-}
-
-void Rasterize(const ConstantBuffer& constantBuffer, ColorBuffer& renderTarget,
-               const std::vector<VertexOutput>& vsOutputs,
-               const std::vector<int>& indices, FragmentShader fs) {
-  std::vector<VertexOutput> culled;
+  ClipPolygon polygon;
 
   for (std::size_t i = 0; i < indices.size(); i += 3) {
-    const VertexOutput& v0 =
-        vsOutputs[static_cast<std::size_t>(indices[i + 0])];
-    const VertexOutput& v1 =
-        vsOutputs[static_cast<std::size_t>(indices[i + 1])];
-    const VertexOutput& v2 =
-        vsOutputs[static_cast<std::size_t>(indices[i + 2])];
+    auto i0 = static_cast<uint32_t>(indices[i + 0]);
+    auto i1 = static_cast<uint32_t>(indices[i + 1]);
+    auto i2 = static_cast<uint32_t>(indices[i + 2]);
 
-    if (FrustumCulling(v0.position, v1.position, v2.position)) {
+    if (outcodes[i0] & outcodes[i1] & outcodes[i2] & RejectMask) {
       continue;
     }
 
-    culled.push_back(v0);
-    culled.push_back(v1);
-    culled.push_back(v2);
-  }
-
-  culled = HomogeneousClipping(culled);
-
-  float halfWidth = static_cast<float>(renderTarget.GetWidth() / 2);
-  float halfHeight = static_cast<float>(renderTarget.GetHeight() / 2);
+    // Triangles inside the guard band are left to the rasterizer's scissor.
+    Outcode straddled = (outcodes[i0] | outcodes[i1] | outcodes[i2]) &
+                        ClipPlaneMask;
+    if (straddled == 0) {
+      assemble(i0, i1, i2);
+      continue;
+    }
 
-  for (std::size_t i = 0; i < culled.size(); i += 3) {
-    for (std::size_t j = 0; j < 3; ++j) {
-      culled[i + j].position =
-          culled[i + j].position / culled[i + j].position[3];
-      culled[i + j].position[0] =
-          culled[i + j].position[0] * halfWidth + halfWidth;
-      culled[i + j].position[1] =
-          culled[i + j].position[1] * halfHeight + halfHeight;
+    std::array<const UserVaryings*, 3> triangleUser{};
+    if (hasUser) {
+      triangleUser = {&user[i0], &user[i1], &user[i2]};
+    }
+    ClipTriangle(vsOutputs[i0], vsOutputs[i1], vsOutputs[i2], triangleUser,
+                 straddled, guardBand, mask, polygon);
+    auto first = static_cast<uint32_t>(vertices.size());
+    for (std::size_t j = 0; j < polygon.size; ++j) {
+      vertices.push_back(ToScreen(polygon.vertices[j], halfSize));
+      if (hasUser) {
+        screenUser.push_back(polygon.user[j]);
+      }
     }
+    for (uint32_t j = 2; j < polygon.size; ++j) {
+      assemble(first, first + j - 1, first + j);
+    }
+  }
 
-    VertexOutput& v0 = culled[i + 0];
-    VertexOutput& v1 = culled[i + 1];
-    VertexOutput& v2 = culled[i + 2];
+  return BinnedTriangles{
+      .triangles = std::move(triangles),
+      .vertices = std::move(vertices),
+      .user = std::move(screenUser),
+      .bins = std::move(bins),
+      .tileCountX = tileCountX,
+      .width = width,
+      .height = height,
+  };
+}
 
-    if (BackfaceCulling(v0.position, v1.position, v2.position)) {
-      continue;
-    }
+template <std::size_t... I>
+static constexpr std::array<VisibilityStage, DepthStateCount>
+MakeVisibilityStages(std::index_sequence<I...>) {
+  return {&RasterizeVisibility<GetDepthState(I)>...};
+}
 
-    DrawTriangle(constantBuffer, renderTarget, v0, v1, v2, fs);
-  }
+VisibilityStage GetVisibilityStage(DepthState state) {
+  static constexpr std::array<VisibilityStage, DepthStateCount> stages =
+      MakeVisibilityStages(std::make_index_sequence<DepthStateCount>{});
+  return stages[GetDepthStateIndex(state)];
 }
 }  // namespace softy
\ No newline at end of file
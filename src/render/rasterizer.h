@@ -1,17 +1,408 @@
 #ifndef RENDER_RASTERIZER_H_
 #define RENDER_RASTERIZER_H_
 
-#include <functional>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
 #include <vector>
 
+#include "core/frame_arena.h"
+#include "core/thread_pool.h"
+#include "math/math.h"
+#include "math/vector.h"
 #include "render/buffer.h"
+#include "render/coverage.h"
+#include "render/gbuffer.h"
+#include "render/render_state.h"
+#include "render/triangle_setup.h"
 #include "render/vertex.h"
-#include "shader/shader.h"
+#include "render/visibility_buffer.h"
+#include "shader/fragment.h"
 
 namespace softy {
-void Rasterize(const ConstantBuffer& constantBuffer, ColorBuffer& renderTarget,
-               const std::vector<VertexOutput>& vsOutputs,
-               const std::vector<int>& indices, FragmentShader fs);
+// Perspective-correct fragments of the quad at (x, y) from its interpolated
+// values. Derivatives are the differences of lanes 1 and 2 to lane 0.
+template <VaryingMask Mask>
+FragmentPacket MakePacket(
+    const std::array<Lanes, Interpolator<Mask>::Count>& quad, int32_t x,
+    int32_t y, uint32_t mask) {
+  using Setup = Interpolator<Mask>;
+  constexpr Lanes dx{0.5f, 1.5f, 0.5f, 1.5f};
+  constexpr Lanes dy{0.5f, 0.5f, 1.5f, 1.5f};
+  const Lanes& z = quad[Setup::Depth];
+  const Lanes& rhw = quad[Setup::Rhw];
+  Lanes w = 1.0f / rhw;
+
+  std::array<Lanes, Setup::Count> varyings{};
+  typename Setup::Values ddx{};
+  typename Setup::Values ddy{};
+  for (std::size_t i = Setup::FirstVarying; i < Setup::Count; ++i) {
+    varyings[i] = quad[i] * w;
+    ddx[i] = varyings[i][1] - varyings[i][0];
+    ddy[i] = varyings[i][2] - varyings[i][0];
+  }
+
+  FragmentPacket packet{};
+  packet.position = {dx + static_cast<float>(x), dy + static_cast<float>(y),
+                     z, rhw};
+
+  std::size_t next = Setup::FirstVarying;
+  auto load = [&]<std::size_t M>(std::array<Lanes, M>& attribute) {
+    for (std::size_t k = 0; k < M; ++k) {
+      attribute[k] = varyings[next++];
+    }
+  };
+  if constexpr ((Mask & varyings::Normal) != 0) {
+    load(packet.normal);
+  }
+  if constexpr ((Mask & varyings::Uv) != 0) {
+    load(packet.uv);
+  }
+  if constexpr ((Mask & varyings::Color) != 0) {
+    load(packet.color);
+  }
+  if constexpr ((Mask & varyings::User0) != 0) {
+    load(packet.user[0]);
+  }
+  if constexpr ((Mask & varyings::User1) != 0) {
+    load(packet.user[1]);
+  }
+
+  packet.ddx.position = v4f{1.0f, 0.0f, z[1] - z[0], rhw[1] - rhw[0]};
+  packet.ddy.position = v4f{0.0f, 1.0f, z[2] - z[0], rhw[2] - rhw[0]};
+  LoadVaryings<Mask>(packet.ddx, ddx, Setup::FirstVarying);
+  LoadVaryings<Mask>(packet.ddy, ddy, Setup::FirstVarying);
+  packet.mask = mask;
+  return packet;
+}
+
+// Varyings a render target reads besides those of the fragment shader.
+template <typename Target>
+inline constexpr VaryingMask TargetVaryings = varyings::None;
+
+template <>
+inline constexpr VaryingMask TargetVaryings<GBufferTarget> = varyings::Normal;
+
+// Writes the pixels in quad, the quad at (x, y), to renderTarget. Quads never
+// straddle blocks, so all four pixels come from one block.
+template <BlendMode Blend>
+void WriteQuad(ColorBuffer& renderTarget, int32_t x, int32_t y, uint32_t quad,
+               const PacketColor& colors, const FragmentPacket&) {
+  PixelBlock<Color> block = renderTarget.GetBlock(x & -BlockSize,
+                                                  y & -BlockSize);
+  int32_t qx = x & (BlockSize - 1);
+  int32_t qy = y & (BlockSize - 1);
+  for (uint32_t bits = quad; bits != 0; bits &= bits - 1) {
+    auto i = static_cast<std::size_t>(std::countr_zero(bits));
+    Color& dst = block(qx + static_cast<int32_t>(i & 1),
+                       qy + static_cast<int32_t>(i >> 1));
+    if constexpr (Blend == BlendMode::Opaque) {
+      dst = colors[i];
+    } else if constexpr (Blend == BlendMode::AlphaBlend) {
+      v4f src{colors[i]};
+      dst = Color{lerp(v4f{dst}, src, src[3])};
+    } else {
+      dst = dst + colors[i];
+    }
+  }
+}
+
+// G-buffers are opaque; Blend is ignored.
+template <BlendMode Blend>
+void WriteQuad(GBufferTarget& renderTarget, int32_t x, int32_t y,
+               uint32_t quad, const PacketColor& colors,
+               const FragmentPacket& packet) {
+  for (uint32_t bits = quad; bits != 0; bits &= bits - 1) {
+    auto i = static_cast<std::size_t>(std::countr_zero(bits));
+    Color color = colors[i];
+    color.a = renderTarget.materialId;
+    v3f normal{packet.normal[0][i], packet.normal[1][i],
+               packet.normal[2][i]};
+    renderTarget.gbuffer->SetTexel(
+        x + static_cast<int32_t>(i & 1), y + static_cast<int32_t>(i >> 1),
+        GBufferTexel{.normal = EncodeNormal(normal), .albedo = color});
+  }
+}
+
+// Calls quadFn(x, y, quad, quadValues) for every quad of triangle inside
+// tile with pixels that pass the depth test. (x, y) is the quad's top-left
+// pixel and quad the mask of its passing pixels.
+template <DepthState Depth, VaryingMask Mask, typename QuadFn>
+void WalkTriangle(DepthBuffer* depthTarget, const TriangleSetup& triangle,
+                  const Interpolator<Mask>& interpolator, PixelRect tile,
+                  QuadFn&& quadFn) {
+  // Always passing without writing is the same as no depth test.
+  constexpr bool depthTest = Depth.func != CompareFunc::Always || Depth.write;
+
+  using Values = typename Interpolator<Mask>::Values;
+
+  int32_t xMin = max(tile.xMin, triangle.bounds.xMin);
+  int32_t xMax = min(tile.xMax, triangle.bounds.xMax);
+  int32_t yMin = max(tile.yMin, triangle.bounds.yMin);
+  int32_t yMax = min(tile.yMax, triangle.bounds.yMax);
+
+  const std::array<Edge, 3>& edges = triangle.edges;
+
+  // Edge values are 64-bit, but inside one tile they move by less than
+  // 2^27, so saturating them at the tile origin keeps every sign exact in
+  // 32 bits.
+  constexpr int64_t saturation = 1ll << 30;
+  std::array<int32_t, 3> tileOrigin{};
+  std::array<int32_t, 3> blockMin{};
+  std::array<int32_t, 3> blockMax{};
+  BlockEdges blockEdges{};
+  for (std::size_t i = 0; i < 3; ++i) {
+    tileOrigin[i] = static_cast<int32_t>(
+        clamp(edges[i].Evaluate(tile.xMin, tile.yMin), -saturation,
+              saturation));
+    blockMin[i] = edges[i].BlockMin();
+    blockMax[i] = edges[i].BlockMax();
+    blockEdges.stepX[i] = edges[i].a;
+    blockEdges.stepY[i] = edges[i].b;
+  }
+
+  CoverageKernel coverage = GetCoverageKernel();
+  Values quadStepX = interpolator.stepX * 2.0f;
+  Values quadStepY = interpolator.stepY * 2.0f;
+
+  // Blocks stay aligned to the tile origin, so they never leave the tile.
+  int32_t bxMin = xMin - (xMin - tile.xMin) % BlockSize;
+  int32_t byMin = yMin - (yMin - tile.yMin) % BlockSize;
+
+  for (int32_t by = byMin; by <= yMax; by += BlockSize) {
+    for (int32_t bx = bxMin; bx <= xMax; bx += BlockSize) {
+      for (std::size_t i = 0; i < 3; ++i) {
+        blockEdges.origin[i] = tileOrigin[i] +
+                               edges[i].a * (bx - tile.xMin) +
+                               edges[i].b * (by - tile.yMin);
+      }
+
+      bool isOutside = false;
+      bool isInside = true;
+      for (std::size_t i = 0; i < 3; ++i) {
+        isOutside |= blockEdges.origin[i] + blockMax[i] < 0;
+        isInside &= blockEdges.origin[i] + blockMin[i] >= 0;
+      }
+
+      if (isOutside) {
+        continue;
+      }
+
+      uint64_t mask = BlockMask(tile.xMax - bx + 1, tile.yMax - by + 1);
+      if (!isInside) {
+        mask &= coverage(blockEdges);
+      }
+
+      PixelBlock<float> depths{};
+      if (depthTest && depthTarget != nullptr) {
+        depths = depthTarget->GetBlock(bx, by);
+      }
+
+      // Quads stay aligned to even pixels since blocks are.
+      Values row = interpolator.Evaluate(bx, by);
+      for (int32_t qy = 0; qy < BlockSize; qy += 2, row += quadStepY) {
+        Values values = row;
+        for (int32_t qx = 0; qx < BlockSize; qx += 2, values += quadStepX) {
+          uint32_t quad = QuadMask(mask, qx, qy);
+          if (quad == 0) {
+            continue;
+          }
+
+          std::array<Lanes, Interpolator<Mask>::Count> quadValues =
+              interpolator.EvaluateQuad(values);
+          int32_t x = bx + qx;
+          int32_t y = by + qy;
+
+          if (depthTest && depthTarget != nullptr) {
+            for (uint32_t bits = quad; bits != 0; bits &= bits - 1) {
+              auto i = static_cast<std::size_t>(std::countr_zero(bits));
+              float& stored = depths(qx + static_cast<int32_t>(i & 1),
+                                     qy + static_cast<int32_t>(i >> 1));
+              float depth = quadValues[Interpolator<Mask>::Depth][i];
+              if (!Compare(Depth.func, depth, stored)) {
+                quad &= ~(1u << i);
+              } else if constexpr (Depth.write) {
+                stored = depth;
+              }
+            }
+            if (quad == 0) {
+              continue;
+            }
+          }
+
+          quadFn(x, y, quad, quadValues);
+        }
+      }
+    }
+  }
+}
+
+// Shades the pixels in quad, the quad at (x, y), and writes them to
+// renderTarget.
+template <BlendMode Blend, VaryingMask Mask, FragmentProgram FS,
+          typename Target>
+void ShadeQuad(const ConstantBuffer& constantBuffer, Target& renderTarget,
+               const FS& fs, int32_t x, int32_t y, uint32_t quad,
+               const std::array<Lanes, Interpolator<Mask>::Count>& quadValues) {
+  FragmentPacket packet = MakePacket<Mask>(quadValues, x, y, quad);
+  PacketColor colors{};
+  if constexpr (PacketFragmentProgram<FS>) {
+    colors = fs(constantBuffer, packet);
+  } else {
+    for (uint32_t bits = quad; bits != 0; bits &= bits - 1) {
+      auto i = static_cast<std::size_t>(std::countr_zero(bits));
+      colors[i] = fs(constantBuffer, GetFragment<Mask>(packet, i));
+    }
+  }
+
+  WriteQuad<Blend>(renderTarget, x, y, quad, colors, packet);
+}
+
+template <RasterState State, FragmentProgram FS, VaryingMask Mask,
+          typename Target>
+void DrawTriangle(const ConstantBuffer& constantBuffer, Target& renderTarget,
+                  DepthBuffer* depthTarget, const TriangleSetup& triangle,
+                  const Interpolator<Mask>& interpolator, const FS& fs,
+                  PixelRect tile) {
+  WalkTriangle<State.depth>(
+      depthTarget, triangle, interpolator, tile,
+      [&](int32_t x, int32_t y, uint32_t quad,
+          const std::array<Lanes, Interpolator<Mask>::Count>& quadValues) {
+        ShadeQuad<State.blend, Mask>(constantBuffer, renderTarget, fs, x, y,
+                                     quad, quadValues);
+      });
+}
+
+// Depth testing is skipped when depthTarget is null. The pixel loop is
+// instantiated per raster state, fragment shader and target type, so fs can
+// be inlined and only the varyings fs declares are interpolated. Target is a
+// ColorBuffer or a GBufferTarget. user is only read when fs declares user
+// varyings.
+template <RasterState State, FragmentProgram FS, typename Target>
+void Rasterize(const ConstantBuffer& constantBuffer, Target& renderTarget,
+               DepthBuffer* depthTarget, CullMode cullMode,
+               std::span<const VertexOutput> vsOutputs,
+               std::span<const UserVaryings> user,
+               const std::vector<int>& indices, const FS& fs) {
+  constexpr VaryingMask mask = GetVaryingMask<FS>() | TargetVaryings<Target>;
+  BinnedTriangles binned =
+      BinTriangles(renderTarget.GetWidth(), renderTarget.GetHeight(),
+                   vsOutputs, user, indices, mask, cullMode);
+
+  FrameVector<Interpolator<mask>> interpolators;
+  interpolators.reserve(binned.triangles.size());
+  for (const TriangleSetup& triangle : binned.triangles) {
+    interpolators.push_back(binned.GetInterpolator<mask>(triangle));
+  }
+
+  ThreadPool::Instance().ParallelFor(
+      binned.bins.size(), [&](std::size_t tileIndex) {
+        const FrameVector<uint32_t>& bin = binned.bins[tileIndex];
+        if (bin.empty()) {
+          return;
+        }
+
+        // Pending clears are written by the worker that owns the tile, right
+        // before it is first drawn to.
+        if constexpr (std::same_as<Target, ColorBuffer>) {
+          renderTarget.ResolveTile(tileIndex);
+        }
+        if (depthTarget != nullptr) {
+          depthTarget->ResolveTile(tileIndex);
+        }
+
+        PixelRect tile = binned.GetTile(tileIndex);
+        for (uint32_t i : bin) {
+          DrawTriangle<State>(constantBuffer, renderTarget, depthTarget,
+                              binned.triangles[i], interpolators[i], fs, tile);
+        }
+      });
+}
+
+// Writes the visibility id of every pixel of triangle that passes the depth
+// test. Only depth is interpolated.
+template <DepthState Depth>
+void DrawTriangleIds(VisibilityTarget& renderTarget, DepthBuffer* depthTarget,
+                     const TriangleSetup& triangle,
+                     const Interpolator<varyings::None>& interpolator,
+                     uint32_t triangleIndex, PixelRect tile) {
+  uint32_t id = MakeVisibilityId(renderTarget.draw, triangleIndex);
+  WalkTriangle<Depth>(
+      depthTarget, triangle, interpolator, tile,
+      [&](int32_t x, int32_t y, uint32_t quad, const auto&) {
+        for (uint32_t bits = quad; bits != 0; bits &= bits - 1) {
+          auto i = static_cast<int32_t>(std::countr_zero(bits));
+          renderTarget.buffer->SetId(x + (i & 1), y + (i >> 1), id);
+        }
+      });
+}
+
+template <DepthState Depth>
+void RasterizeVisibility(VisibilityTarget& renderTarget,
+                         DepthBuffer* depthTarget,
+                         const BinnedTriangles& binned) {
+  assert(binned.triangles.size() <= MaxVisibilityTriangles);
+  FrameVector<Interpolator<varyings::None>> interpolators;
+  interpolators.reserve(binned.triangles.size());
+  for (const TriangleSetup& triangle : binned.triangles) {
+    interpolators.push_back(binned.GetInterpolator<varyings::None>(triangle));
+  }
+
+  ThreadPool::Instance().ParallelFor(
+      binned.bins.size(), [&](std::size_t tileIndex) {
+        const FrameVector<uint32_t>& bin = binned.bins[tileIndex];
+        if (bin.empty()) {
+          return;
+        }
+
+        if (depthTarget != nullptr) {
+          depthTarget->ResolveTile(tileIndex);
+        }
+
+        PixelRect tile = binned.GetTile(tileIndex);
+        for (uint32_t i : bin) {
+          DrawTriangleIds<Depth>(renderTarget, depthTarget,
+                                 binned.triangles[i], interpolators[i], i,
+                                 tile);
+        }
+      });
+}
+
+using VisibilityStage = void (*)(VisibilityTarget&, DepthBuffer*,
+                                 const BinnedTriangles&);
+
+// RasterizeVisibility compiled for state.
+VisibilityStage GetVisibilityStage(DepthState state);
+
+// Shades quads found in a visibility buffer, all from the draw binned was
+// built for. Attributes are reconstructed from the triangle's vertices, so
+// sorting quads by id lets consecutive quads share the setup.
+template <FragmentProgram FS>
+void ResolveQuads(const ConstantBuffer& constantBuffer,
+                  ColorBuffer& renderTarget, const BinnedTriangles& binned,
+                  std::span<const VisibleQuad> quads, const FS& fs) {
+  constexpr VaryingMask mask = GetVaryingMask<FS>();
+  std::optional<Interpolator<mask>> interpolator;
+  uint32_t current = EmptyVisibility;
+
+  for (const VisibleQuad& quad : quads) {
+    if (quad.id != current) {
+      const TriangleSetup& triangle =
+          binned.triangles[GetVisibilityTriangle(quad.id)];
+      interpolator = binned.GetInterpolator<mask>(triangle);
+      current = quad.id;
+    }
+
+    ShadeQuad<BlendMode::Opaque, mask>(
+        constantBuffer, renderTarget, fs, quad.x, quad.y, quad.mask,
+        interpolator->EvaluateQuad(interpolator->Evaluate(quad.x, quad.y)));
+  }
+}
 }  // namespace softy
 
 #endif  // RENDER_RASTERIZER_H_
\ No newline at end of file
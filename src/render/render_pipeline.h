@@ -4,9 +4,11 @@
 #include <cstdint>
 #include <vector>
 
+#include "core/frame_arena.h"
 #include "math/matrix.h"
 #include "render/buffer.h"
 #include "render/camera.h"
+#include "render/light.h"
 #include "render/material.h"
 #include "render/mesh.h"
 
@@ -24,12 +26,25 @@ class RenderPipeline {
     transforms_.push_back(transform);
   }
 
-  virtual void Render(Camera* camera) = 0;
+  void AddLight(const Light& light) { lights_.push_back(light); }
+
+  // Draws everything added since the last call and ends the frame: every
+  // FrameArena is reset, so no FrameVector may outlive the call.
+  void Render(Camera* camera) {
+    RenderFrame(camera);
+    meshes_.clear();
+    transforms_.clear();
+    lights_.clear();
+    FrameArena::ResetAll();
+  }
 
  protected:
+  virtual void RenderFrame(Camera* camera) = 0;
+
   ConstantBuffer* constantBuffer_;
   std::vector<const Mesh*> meshes_;
   std::vector<mat4> transforms_;
+  std::vector<Light> lights_;
 };
 }  // namespace softy
 
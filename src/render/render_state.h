@@ -0,0 +1,102 @@
+#ifndef RENDER_RENDER_STATE_H_
+#define RENDER_RENDER_STATE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace softy {
+enum class CompareFunc : uint8_t {
+  Never,
+  Less,
+  LessEqual,
+  Equal,
+  GreaterEqual,
+  Greater,
+  NotEqual,
+  Always,
+};
+
+inline constexpr std::size_t CompareFuncCount = 8;
+
+struct DepthState {
+  CompareFunc func{CompareFunc::Less};
+  bool write{true};
+
+  bool operator==(const DepthState&) const = default;
+};
+
+inline constexpr std::size_t DepthStateCount = CompareFuncCount * 2;
+
+constexpr std::size_t GetDepthStateIndex(DepthState state) {
+  return static_cast<std::size_t>(state.func) * 2 +
+         static_cast<std::size_t>(state.write);
+}
+
+constexpr DepthState GetDepthState(std::size_t index) {
+  return DepthState{.func = static_cast<CompareFunc>(index / 2),
+                    .write = index % 2 != 0};
+}
+
+// Triangles of the culled winding are discarded before setup.
+enum class CullMode : uint8_t {
+  None,
+  Back,
+  Front,
+};
+
+// How a shaded color is combined with the render target.
+enum class BlendMode : uint8_t {
+  Opaque,
+  AlphaBlend,
+  Additive,
+};
+
+inline constexpr std::size_t BlendModeCount = 3;
+
+// Per-pixel state that raster kernels are compiled for.
+struct RasterState {
+  DepthState depth;
+  BlendMode blend{BlendMode::Opaque};
+
+  bool operator==(const RasterState&) const = default;
+};
+
+inline constexpr std::size_t RasterStateCount =
+    DepthStateCount * BlendModeCount;
+
+constexpr std::size_t GetRasterStateIndex(RasterState state) {
+  return GetDepthStateIndex(state.depth) * BlendModeCount +
+         static_cast<std::size_t>(state.blend);
+}
+
+constexpr RasterState GetRasterState(std::size_t index) {
+  return RasterState{
+      .depth = GetDepthState(index / BlendModeCount),
+      .blend = static_cast<BlendMode>(index % BlendModeCount),
+  };
+}
+
+constexpr bool Compare(CompareFunc func, float src, float dst) {
+  switch (func) {
+    case CompareFunc::Never:
+      return false;
+    case CompareFunc::Less:
+      return src < dst;
+    case CompareFunc::LessEqual:
+      return src <= dst;
+    case CompareFunc::Equal:
+      return src == dst;
+    case CompareFunc::GreaterEqual:
+      return src >= dst;
+    case CompareFunc::Greater:
+      return src > dst;
+    case CompareFunc::NotEqual:
+      return src != dst;
+    case CompareFunc::Always:
+      return true;
+  }
+  return false;
+}
+}  // namespace softy
+
+#endif  // RENDER_RENDER_STATE_H_
\ No newline at end of file
@@ -0,0 +1,278 @@
+#include "render/sampler.h"
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SOFTY_X86 1
+#include <immintrin.h>
+#endif
+
+#include "math/math.h"
+#include "math/vector.h"
+#include "render/color.h"
+#include "render/texture.h"
+#include "shader/fragment.h"
+
+namespace softy {
+static constexpr float TexelScale = 1.0f / 255.0f;
+
+// Maps u into [0, 1] for every mode but Wrap, which maps into [0, 1) and
+// leaves the wrap of the second bilinear texel to WrapTexel. NaNs and
+// infinities map to 0, as they have no place in the texture.
+static float Address(float u, AddressMode mode) {
+  if (!std::isfinite(u)) {
+    u = 0.0f;
+  }
+  switch (mode) {
+    case AddressMode::Wrap:
+      return u - floor(u);
+    case AddressMode::Mirror: {
+      float t = u - 2.0f * floor(u * 0.5f);
+      return min(t, 2.0f - t);
+    }
+    default:
+      return clamp(u, 0.0f, 1.0f);
+  }
+}
+
+static int32_t WrapTexel(int32_t i, int32_t size, AddressMode mode) {
+  if (mode == AddressMode::Wrap) {
+    return i < 0 ? i + size : (i >= size ? i - size : i);
+  }
+  return clamp(i, 0, size - 1);
+}
+
+void SampleScalar(const Texture2D& texture, int32_t level,
+                  const Sampler& sampler, const std::array<Lanes, 2>& uv,
+                  TexelPacket& texels) {
+  const TextureLevel& l = texture.GetLevel(level);
+  const Color* data = texture.GetTexels();
+  bool bilinear = sampler.filter != FilterMode::Point;
+  float offset = bilinear ? 0.5f : 0.0f;
+
+  for (std::size_t lane = 0; lane < PacketSize; ++lane) {
+    float x = Address(uv[0][lane], sampler.addressU) *
+                  static_cast<float>(l.width) -
+              offset;
+    float y = Address(uv[1][lane], sampler.addressV) *
+                  static_cast<float>(l.height) -
+              offset;
+    float x0 = floor(x);
+    float y0 = floor(y);
+    float tx = bilinear ? x - x0 : 0.0f;
+    float ty = bilinear ? y - y0 : 0.0f;
+    auto ix = static_cast<int32_t>(x0);
+    auto iy = static_cast<int32_t>(y0);
+    int32_t ix0 = WrapTexel(ix, l.width, sampler.addressU);
+    int32_t ix1 = WrapTexel(ix + 1, l.width, sampler.addressU);
+    int32_t iy0 = WrapTexel(iy, l.height, sampler.addressV);
+    int32_t iy1 = WrapTexel(iy + 1, l.height, sampler.addressV);
+
+    Color c00 = data[l.GetTexelIndex(ix0, iy0)];
+    Color c10 = data[l.GetTexelIndex(ix1, iy0)];
+    Color c01 = data[l.GetTexelIndex(ix0, iy1)];
+    Color c11 = data[l.GetTexelIndex(ix1, iy1)];
+    auto filter = [tx, ty](float a00, float a10, float a01, float a11) {
+      float top = a00 + (a10 - a00) * tx;
+      float bottom = a01 + (a11 - a01) * tx;
+      return (top + (bottom - top) * ty) * TexelScale;
+    };
+    texels[0][lane] = filter(c00.r, c10.r, c01.r, c11.r);
+    texels[1][lane] = filter(c00.g, c10.g, c01.g, c11.g);
+    texels[2][lane] = filter(c00.b, c10.b, c01.b, c11.b);
+    texels[3][lane] = filter(c00.a, c10.a, c01.a, c11.a);
+  }
+}
+
+#if SOFTY_X86
+#define SOFTY_AVX2 __attribute__((target("avx2")))
+
+SOFTY_AVX2 static __m128 AddressAvx2(__m128 u, AddressMode mode) {
+  // u - u is 0 only for finite u.
+  __m128 finite = _mm_cmpeq_ps(_mm_sub_ps(u, u), _mm_setzero_ps());
+  u = _mm_and_ps(u, finite);
+  switch (mode) {
+    case AddressMode::Wrap:
+      return _mm_sub_ps(u, _mm_floor_ps(u));
+    case AddressMode::Mirror: {
+      __m128 half = _mm_floor_ps(_mm_mul_ps(u, _mm_set1_ps(0.5f)));
+      __m128 t = _mm_sub_ps(u, _mm_add_ps(half, half));
+      return _mm_min_ps(t, _mm_sub_ps(_mm_set1_ps(2.0f), t));
+    }
+    default:
+      return _mm_min_ps(_mm_max_ps(u, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+  }
+}
+
+SOFTY_AVX2 static __m128i WrapTexelAvx2(__m128i i, int32_t size,
+                                        AddressMode mode) {
+  __m128i s = _mm_set1_epi32(size);
+  if (mode == AddressMode::Wrap) {
+    __m128i below = _mm_cmpgt_epi32(_mm_setzero_si128(), i);
+    __m128i above = _mm_cmpgt_epi32(i, _mm_sub_epi32(s, _mm_set1_epi32(1)));
+    i = _mm_add_epi32(i, _mm_and_si128(below, s));
+    return _mm_sub_epi32(i, _mm_and_si128(above, s));
+  }
+  return _mm_max_epi32(_mm_min_epi32(i, _mm_sub_epi32(s, _mm_set1_epi32(1))),
+                       _mm_setzero_si128());
+}
+
+// Storage index of texel (x, y), matching TextureLevel::GetTexelIndex.
+SOFTY_AVX2 static __m128i TexelIndexAvx2(const TextureLevel& l, __m128i x,
+                                         __m128i y) {
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i two = _mm_set1_epi32(2);
+  __m128i tile = _mm_add_epi32(
+      _mm_mullo_epi32(_mm_srai_epi32(y, TextureTileBits),
+                      _mm_set1_epi32(l.tileCountX)),
+      _mm_srai_epi32(x, TextureTileBits));
+  __m128i morton = _mm_or_si128(
+      _mm_or_si128(_mm_and_si128(x, one),
+                   _mm_slli_epi32(_mm_and_si128(y, one), 1)),
+      _mm_or_si128(_mm_slli_epi32(_mm_and_si128(x, two), 1),
+                   _mm_slli_epi32(_mm_and_si128(y, two), 2)));
+  return _mm_add_epi32(
+      _mm_set1_epi32(static_cast<int32_t>(l.offset)),
+      _mm_add_epi32(_mm_slli_epi32(tile, 4), morton));
+}
+
+SOFTY_AVX2 static __m128 ChannelAvx2(__m128i texels, int shift) {
+  __m128i c = _mm_and_si128(_mm_srli_epi32(texels, shift),
+                            _mm_set1_epi32(0xFF));
+  return _mm_cvtepi32_ps(c);
+}
+
+SOFTY_AVX2 static __m128 LerpAvx2(__m128 a, __m128 b, __m128 t) {
+  return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+}
+
+SOFTY_AVX2 void SampleAvx2(const Texture2D& texture, int32_t level,
+                           const Sampler& sampler,
+                           const std::array<Lanes, 2>& uv,
+                           TexelPacket& texels) {
+  const TextureLevel& l = texture.GetLevel(level);
+  const auto* data = reinterpret_cast<const int*>(texture.GetTexels());
+  bool bilinear = sampler.filter != FilterMode::Point;
+  __m128 offset = _mm_set1_ps(bilinear ? 0.5f : 0.0f);
+
+  __m128 x = _mm_sub_ps(
+      _mm_mul_ps(AddressAvx2(_mm_loadu_ps(uv[0].v.data()), sampler.addressU),
+                 _mm_set1_ps(static_cast<float>(l.width))),
+      offset);
+  __m128 y = _mm_sub_ps(
+      _mm_mul_ps(AddressAvx2(_mm_loadu_ps(uv[1].v.data()), sampler.addressV),
+                 _mm_set1_ps(static_cast<float>(l.height))),
+      offset);
+  __m128 x0 = _mm_floor_ps(x);
+  __m128 y0 = _mm_floor_ps(y);
+  __m128i ix = _mm_cvttps_epi32(x0);
+  __m128i iy = _mm_cvttps_epi32(y0);
+  const __m128i one = _mm_set1_epi32(1);
+  __m128i ix0 = WrapTexelAvx2(ix, l.width, sampler.addressU);
+  __m128i iy0 = WrapTexelAvx2(iy, l.height, sampler.addressV);
+
+  static constexpr int Shifts[4] = {16, 8, 0, 24};
+  if (!bilinear) {
+    __m128i c = _mm_i32gather_epi32(data, TexelIndexAvx2(l, ix0, iy0), 4);
+    for (std::size_t i = 0; i < 4; ++i) {
+      __m128 channel = ChannelAvx2(c, Shifts[i]);
+      _mm_storeu_ps(texels[i].v.data(),
+                    _mm_mul_ps(channel, _mm_set1_ps(TexelScale)));
+    }
+    return;
+  }
+
+  __m128i ix1 =
+      WrapTexelAvx2(_mm_add_epi32(ix, one), l.width, sampler.addressU);
+  __m128i iy1 =
+      WrapTexelAvx2(_mm_add_epi32(iy, one), l.height, sampler.addressV);
+  __m128 tx = _mm_sub_ps(x, x0);
+  __m128 ty = _mm_sub_ps(y, y0);
+
+  __m128i c00 = _mm_i32gather_epi32(data, TexelIndexAvx2(l, ix0, iy0), 4);
+  __m128i c10 = _mm_i32gather_epi32(data, TexelIndexAvx2(l, ix1, iy0), 4);
+  __m128i c01 = _mm_i32gather_epi32(data, TexelIndexAvx2(l, ix0, iy1), 4);
+  __m128i c11 = _mm_i32gather_epi32(data, TexelIndexAvx2(l, ix1, iy1), 4);
+  for (std::size_t i = 0; i < 4; ++i) {
+    __m128 top = LerpAvx2(ChannelAvx2(c00, Shifts[i]),
+                          ChannelAvx2(c10, Shifts[i]), tx);
+    __m128 bottom = LerpAvx2(ChannelAvx2(c01, Shifts[i]),
+                             ChannelAvx2(c11, Shifts[i]), tx);
+    _mm_storeu_ps(texels[i].v.data(),
+                  _mm_mul_ps(LerpAvx2(top, bottom, ty),
+                             _mm_set1_ps(TexelScale)));
+  }
+}
+
+SampleKernel GetSampleKernel() {
+  static const SampleKernel kernel = []() -> SampleKernel {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      return SampleAvx2;
+    }
+    return SampleScalar;
+  }();
+  return kernel;
+}
+#else
+void SampleAvx2(const Texture2D& texture, int32_t level,
+                const Sampler& sampler, const std::array<Lanes, 2>& uv,
+                TexelPacket& texels) {
+  SampleScalar(texture, level, sampler, uv, texels);
+}
+
+SampleKernel GetSampleKernel() { return SampleScalar; }
+#endif
+
+float GetMipLevel(const Texture2D& texture, v2f ddx, v2f ddy) {
+  v2f size{static_cast<float>(texture.GetWidth()),
+           static_cast<float>(texture.GetHeight())};
+  v2f dx = ddx * size;
+  v2f dy = ddy * size;
+  float rho = max(dot(dx, dx), dot(dy, dy));
+  // Also catches NaN derivatives.
+  if (!(rho > 1.0f)) {
+    return 0.0f;
+  }
+  return min(0.5f * log2(rho),
+             static_cast<float>(texture.GetLevelCount() - 1));
+}
+
+TexelPacket Sample(const Texture2D& texture, const Sampler& sampler,
+                   const std::array<Lanes, 2>& uv, v2f ddx, v2f ddy) {
+  SampleKernel kernel = GetSampleKernel();
+  float lod = GetMipLevel(texture, ddx, ddy);
+  TexelPacket texels{};
+  if (sampler.filter != FilterMode::Trilinear) {
+    kernel(texture, static_cast<int32_t>(lod + 0.5f), sampler, uv, texels);
+    return texels;
+  }
+
+  auto level = static_cast<int32_t>(lod);
+  float t = lod - static_cast<float>(level);
+  kernel(texture, level, sampler, uv, texels);
+  if (t > 0.0f) {
+    TexelPacket next{};
+    kernel(texture, level + 1, sampler, uv, next);
+    for (std::size_t i = 0; i < texels.size(); ++i) {
+      texels[i] = texels[i] + (next[i] - texels[i]) * t;
+    }
+  }
+  return texels;
+}
+
+v4f Sample(const Texture2D& texture, const Sampler& sampler,
+           const Fragment& fragment) {
+  std::array<Lanes, 2> uv{};
+  for (std::size_t lane = 0; lane < PacketSize; ++lane) {
+    uv[0][lane] = fragment.v.uv[0];
+    uv[1][lane] = fragment.v.uv[1];
+  }
+  TexelPacket texels =
+      Sample(texture, sampler, uv, fragment.ddx.uv, fragment.ddy.uv);
+  return v4f{texels[0][0], texels[1][0], texels[2][0], texels[3][0]};
+}
+}  // namespace softy
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef RENDER_SAMPLER_H_
+#define RENDER_SAMPLER_H_
+
+#include <array>
+#include <cstdint>
+
+#include "math/vector.h"
+#include "render/texture.h"
+#include "shader/fragment.h"
+
+namespace softy {
+enum class FilterMode : uint8_t {
+  Point,
+  Bilinear,
+  // Bilinear in the two nearest mip levels, blended by the fractional level.
+  Trilinear,
+};
+
+// How texture coordinates outside [0, 1] map back into the texture.
+enum class AddressMode : uint8_t {
+  Wrap,
+  Clamp,
+  Mirror,
+};
+
+struct Sampler {
+  FilterMode filter{FilterMode::Trilinear};
+  AddressMode addressU{AddressMode::Wrap};
+  AddressMode addressV{AddressMode::Wrap};
+
+  bool operator==(const Sampler&) const = default;
+};
+
+// Red, green, blue and alpha of every lane, in [0, 1].
+using TexelPacket = std::array<Lanes, 4>;
+
+// Filters mip level of texture at the uv of every lane. Trilinear filtering
+// is bilinear here; blending levels is left to the caller.
+using SampleKernel = void (*)(const Texture2D& texture, int32_t level,
+                              const Sampler& sampler,
+                              const std::array<Lanes, 2>& uv,
+                              TexelPacket& texels);
+
+void SampleScalar(const Texture2D& texture, int32_t level,
+                  const Sampler& sampler, const std::array<Lanes, 2>& uv,
+                  TexelPacket& texels);
+void SampleAvx2(const Texture2D& texture, int32_t level,
+                const Sampler& sampler, const std::array<Lanes, 2>& uv,
+                TexelPacket& texels);
+
+// The widest kernel the running CPU supports. Resolved once.
+SampleKernel GetSampleKernel();
+
+// Fractional mip level for uv derivatives ddx and ddy, clamped to the
+// texture's levels.
+float GetMipLevel(const Texture2D& texture, v2f ddx, v2f ddy);
+
+// Samples texture at the uvs of a 2x2 quad. The mip level is chosen once for
+// the quad from the uv derivatives.
+TexelPacket Sample(const Texture2D& texture, const Sampler& sampler,
+                   const std::array<Lanes, 2>& uv, v2f ddx, v2f ddy);
+
+inline TexelPacket Sample(const Texture2D& texture, const Sampler& sampler,
+                          const FragmentPacket& packet) {
+  return Sample(texture, sampler, packet.uv, packet.ddx.uv, packet.ddy.uv);
+}
+
+v4f Sample(const Texture2D& texture, const Sampler& sampler,
+           const Fragment& fragment);
+}  // namespace softy
+
+#endif  // RENDER_SAMPLER_H_
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "render/texture.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "math/math.h"
+#include "render/buffer.h"
+#include "render/color.h"
+
+namespace softy {
+Texture2D::Texture2D(int32_t width, int32_t height,
+                     std::span<const Color> texels) {
+  assert(width > 0 && height > 0 &&
+         texels.size() == static_cast<std::size_t>(width * height));
+
+  // Levels are padded to whole tiles.
+  std::size_t size{};
+  for (int32_t w = width, h = height;; w = max(w / 2, 1), h = max(h / 2, 1)) {
+    int32_t tileCountX = (w + TextureTileSize - 1) >> TextureTileBits;
+    int32_t tileCountY = (h + TextureTileSize - 1) >> TextureTileBits;
+    levels_.push_back(TextureLevel{
+        .width = w,
+        .height = h,
+        .tileCountX = tileCountX,
+        .offset = size,
+    });
+    size += static_cast<std::size_t>(tileCountX * tileCountY) *
+            TextureTileTexels;
+    if (w == 1 && h == 1) {
+      break;
+    }
+  }
+
+  buffer_.Allocate(BitCount<Color>(), size);
+  Color* data = buffer_.Get<Color>();
+
+  const TextureLevel& base = levels_[0];
+  for (int32_t y = 0; y < height; ++y) {
+    for (int32_t x = 0; x < width; ++x) {
+      data[base.GetTexelIndex(x, y)] =
+          texels[static_cast<std::size_t>(y * width + x)];
+    }
+  }
+
+  for (std::size_t i = 1; i < levels_.size(); ++i) {
+    const TextureLevel& src = levels_[i - 1];
+    const TextureLevel& dst = levels_[i];
+    for (int32_t y = 0; y < dst.height; ++y) {
+      int32_t y0 = min(y * 2, src.height - 1);
+      int32_t y1 = min(y * 2 + 1, src.height - 1);
+      for (int32_t x = 0; x < dst.width; ++x) {
+        int32_t x0 = min(x * 2, src.width - 1);
+        int32_t x1 = min(x * 2 + 1, src.width - 1);
+        Color c00 = data[src.GetTexelIndex(x0, y0)];
+        Color c10 = data[src.GetTexelIndex(x1, y0)];
+        Color c01 = data[src.GetTexelIndex(x0, y1)];
+        Color c11 = data[src.GetTexelIndex(x1, y1)];
+
+        auto average = [](uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+          return static_cast<uint8_t>((a + b + c + d + 2) / 4);
+        };
+        Color color{};
+        color.r = average(c00.r, c10.r, c01.r, c11.r);
+        color.g = average(c00.g, c10.g, c01.g, c11.g);
+        color.b = average(c00.b, c10.b, c01.b, c11.b);
+        color.a = average(c00.a, c10.a, c01.a, c11.a);
+        data[dst.GetTexelIndex(x, y)] = color;
+      }
+    }
+  }
+}
+
+Color Texture2D::GetTexel(int32_t level, int32_t x, int32_t y) const {
+  const TextureLevel& l = GetLevel(level);
+  assert(x >= 0 && x < l.width && y >= 0 && y < l.height);
+  return GetTexels()[l.GetTexelIndex(x, y)];
+}
+}  // namespace softy
\ No newline at end of file
@@ -0,0 +1,73 @@
+#ifndef RENDER_TEXTURE_H_
+#define RENDER_TEXTURE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "render/buffer.h"
+#include "render/color.h"
+
+namespace softy {
+// Texels are stored in TextureTileSize x TextureTileSize tiles of one cache
+// line each, so a bilinear footprint touches at most four lines and usually
+// one or two.
+inline constexpr int32_t TextureTileBits = 2;
+inline constexpr int32_t TextureTileSize = 1 << TextureTileBits;
+inline constexpr int32_t TextureTileTexels = TextureTileSize * TextureTileSize;
+
+// Z-order index of a texel inside its tile.
+constexpr uint32_t GetTileTexelIndex(uint32_t x, uint32_t y) {
+  return (x & 1u) | ((y & 1u) << 1) | ((x & 2u) << 1) | ((y & 2u) << 2);
+}
+
+struct TextureLevel {
+  int32_t width;
+  int32_t height;
+  int32_t tileCountX;
+  // First texel of the level in the texture's storage.
+  std::size_t offset;
+
+  std::size_t GetTexelIndex(int32_t x, int32_t y) const {
+    auto tile = static_cast<std::size_t>((y >> TextureTileBits) * tileCountX +
+                                         (x >> TextureTileBits));
+    return offset + tile * TextureTileTexels +
+           GetTileTexelIndex(static_cast<uint32_t>(x),
+                             static_cast<uint32_t>(y));
+  }
+};
+
+class Texture2D {
+ public:
+  Texture2D() = default;
+  // texels holds width * height colors in row-major order. The full mip
+  // chain down to 1x1 is built with a box filter.
+  Texture2D(int32_t width, int32_t height, std::span<const Color> texels);
+
+  // Zero for an empty texture.
+  int32_t GetWidth() const noexcept {
+    return levels_.empty() ? 0 : levels_[0].width;
+  }
+  int32_t GetHeight() const noexcept {
+    return levels_.empty() ? 0 : levels_[0].height;
+  }
+  int32_t GetLevelCount() const noexcept {
+    return static_cast<int32_t>(levels_.size());
+  }
+  const TextureLevel& GetLevel(int32_t level) const {
+    return levels_[static_cast<std::size_t>(level)];
+  }
+  const Color* GetTexels() const noexcept {
+    return static_cast<const Color*>(buffer_.Get());
+  }
+
+  Color GetTexel(int32_t level, int32_t x, int32_t y) const;
+
+ private:
+  Buffer buffer_;
+  std::vector<TextureLevel> levels_;
+};
+}  // namespace softy
+
+#endif  // RENDER_TEXTURE_H_
\ No newline at end of file
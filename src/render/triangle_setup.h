@@ -0,0 +1,203 @@
+#ifndef RENDER_TRIANGLE_SETUP_H_
+#define RENDER_TRIANGLE_SETUP_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "core/frame_arena.h"
+#include "math/math.h"
+#include "math/vector.h"
+#include "render/buffer.h"
+#include "render/coverage.h"
+#include "render/render_state.h"
+#include "render/vertex.h"
+#include "shader/fragment.h"
+
+namespace softy {
+// Vertex positions are snapped to 24.8 fixed point before setup.
+inline constexpr int32_t SubPixelBits = 8;
+inline constexpr int32_t SubPixelOne = 1 << SubPixelBits;
+
+// Screen space is y-up, so left edges run downwards and top edges run in -x.
+inline bool IsTopOrLeftEdge(v2i v0, v2i v1) {
+  v2i e = v1 - v0;
+  bool isLeft = e[1] < 0;
+  bool isTop = e[1] == 0 && e[0] < 0;
+  return isLeft | isTop;
+}
+
+// Edge function of two fixed-point vertices, reduced to whole pixels: pixel
+// (x, y) is inside when a * x + b * y + c >= 0. It is exact for samples at
+// pixel centers, with the top-left fill rule folded into c.
+struct Edge {
+  Edge(v2i v0, v2i v1) : a{v0[1] - v1[1]}, b{v1[0] - v0[0]} {
+    int64_t c0 = static_cast<int64_t>(v0[0]) * v1[1] -
+                 static_cast<int64_t>(v0[1]) * v1[0];
+    int64_t center = c0 + static_cast<int64_t>(a + b) * (SubPixelOne / 2);
+    int64_t bias = IsTopOrLeftEdge(v0, v1) ? 0 : -1;
+    c = (center + bias) >> SubPixelBits;
+  }
+
+  int64_t Evaluate(int32_t x, int32_t y) const {
+    return static_cast<int64_t>(a) * x + static_cast<int64_t>(b) * y + c;
+  }
+
+  // Smallest and largest value over a block, relative to its first pixel.
+  int32_t BlockMin() const {
+    return (min(a, 0) + min(b, 0)) * (BlockSize - 1);
+  }
+  int32_t BlockMax() const {
+    return (max(a, 0) + max(b, 0)) * (BlockSize - 1);
+  }
+
+  int32_t a;
+  int32_t b;
+  int64_t c;
+};
+
+// Screen-space plane equations of z, 1/w and every varying in Mask divided
+// by w. Set up once per triangle; per pixel the values are stepped with adds
+// and the varyings are recovered with a single divide.
+template <VaryingMask Mask>
+struct Interpolator {
+  // z and 1/w come first, followed by the varyings.
+  static constexpr std::size_t Depth = 0;
+  static constexpr std::size_t Rhw = 1;
+  static constexpr std::size_t FirstVarying = 2;
+  static constexpr std::size_t Count = FirstVarying + VaryingFloatCount(Mask);
+  using Values = vec<float, Count>;
+
+  // user holds the user varyings of v0, v1 and v2 when Mask has some.
+  Interpolator(const VertexOutput& v0, const VertexOutput& v1,
+               const VertexOutput& v2,
+               std::array<const UserVaryings*, 3> user = {}) {
+    std::array<const VertexOutput*, 3> verts{&v0, &v1, &v2};
+    std::array<Values, 3> f{};
+    for (std::size_t i = 0; i < 3; ++i) {
+      float rhw = verts[i]->position[3];
+      StoreVaryings<Mask>(*verts[i], user[i], f[i], FirstVarying);
+      f[i] = f[i] * rhw;
+      f[i][Depth] = verts[i]->position[2];
+      f[i][Rhw] = rhw;
+    }
+
+    v2f p0{v0.position};
+    v2f e1 = v2f{v1.position} - p0;
+    v2f e2 = v2f{v2.position} - p0;
+    float invArea = 1.0f / cross(e1, e2);
+
+    Values d1 = f[1] - f[0];
+    Values d2 = f[2] - f[0];
+    stepX = (d1 * e2[1] - d2 * e1[1]) * invArea;
+    stepY = (d2 * e1[0] - d1 * e2[0]) * invArea;
+    // Evaluate(x, y) samples the center of pixel (x, y).
+    origin = f[0] - stepX * (p0[0] - 0.5f) - stepY * (p0[1] - 0.5f);
+  }
+
+  Values Evaluate(int32_t x, int32_t y) const {
+    return origin + stepX * static_cast<float>(x) +
+           stepY * static_cast<float>(y);
+  }
+
+  // Values at the pixels of the 2x2 quad whose first pixel has values, one
+  // vector of lanes per component.
+  std::array<Lanes, Count> EvaluateQuad(const Values& values) const {
+    constexpr Lanes dx{0.0f, 1.0f, 0.0f, 1.0f};
+    constexpr Lanes dy{0.0f, 0.0f, 1.0f, 1.0f};
+    std::array<Lanes, Count> quad{};
+    for (std::size_t i = 0; i < Count; ++i) {
+      quad[i] = dx * stepX[i] + dy * stepY[i] + values[i];
+    }
+    return quad;
+  }
+
+  Values origin;
+  Values stepX;
+  Values stepY;
+};
+
+// Coverage of the 2x2 quad at (x, y) within a block, bit (dy * 2 + dx).
+inline uint32_t QuadMask(uint64_t mask, int32_t x, int32_t y) {
+  uint64_t rows = mask >> (y * BlockSize + x);
+  return static_cast<uint32_t>((rows & 0x3) | ((rows >> BlockSize) & 0x3) << 2);
+}
+
+// Inclusive pixel rectangle.
+struct PixelRect {
+  int32_t xMin;
+  int32_t yMin;
+  int32_t xMax;
+  int32_t yMax;
+};
+
+// A vertex after the perspective divide and viewport transform. Positions
+// hold the snapped window coordinates, depth and 1/w.
+struct ScreenVertex {
+  VertexOutput vertex;
+  v2i fixed;
+};
+
+// Coverage setup of a triangle. Its attributes are set up separately, from
+// the screen vertices it indexes, once the varyings to interpolate are known.
+struct TriangleSetup {
+  std::array<Edge, 3> edges;
+  PixelRect bounds;
+  std::array<uint32_t, 3> vertices;
+};
+
+// Set-up triangles of one draw, the screen vertices they index and, per
+// screen tile, the indices of the triangles that overlap it. Lives in the
+// frame arena of the thread that binned it.
+struct BinnedTriangles {
+  // The varyings in Mask of triangle, set up from its screen vertices.
+  template <VaryingMask Mask>
+  Interpolator<Mask> GetInterpolator(const TriangleSetup& triangle) const {
+    std::array<const UserVaryings*, 3> triangleUser{};
+    if constexpr ((Mask & varyings::User) != 0) {
+      for (std::size_t i = 0; i < 3; ++i) {
+        triangleUser[i] = &user[triangle.vertices[i]];
+      }
+    }
+    return Interpolator<Mask>{vertices[triangle.vertices[0]].vertex,
+                              vertices[triangle.vertices[1]].vertex,
+                              vertices[triangle.vertices[2]].vertex,
+                              triangleUser};
+  }
+
+  PixelRect GetTile(std::size_t index) const {
+    int32_t tx = static_cast<int32_t>(index) % tileCountX;
+    int32_t ty = static_cast<int32_t>(index) / tileCountX;
+    return PixelRect{
+        .xMin = tx * TileSize,
+        .yMin = ty * TileSize,
+        .xMax = min((tx + 1) * TileSize, width) - 1,
+        .yMax = min((ty + 1) * TileSize, height) - 1,
+    };
+  }
+
+  FrameVector<TriangleSetup> triangles;
+  FrameVector<ScreenVertex> vertices;
+  // User varyings of the screen vertices. Empty unless they were binned with
+  // user varyings.
+  FrameVector<UserVaryings> user;
+  FrameVector<FrameVector<uint32_t>> bins;
+  int32_t tileCountX;
+  int32_t width;
+  int32_t height;
+};
+
+// Clips, projects and sets up the indexed triangles of vsOutputs for a
+// width x height target, then bins them by tile. Clipping only interpolates
+// the varyings in mask. user holds one UserVaryings per vertex when mask has
+// user varyings and is ignored otherwise.
+BinnedTriangles BinTriangles(int32_t width, int32_t height,
+                             std::span<const VertexOutput> vsOutputs,
+                             std::span<const UserVaryings> user,
+                             std::span<const int32_t> indices,
+                             VaryingMask mask, CullMode cullMode);
+}  // namespace softy
+
+#endif  // RENDER_TRIANGLE_SETUP_H_
\ No newline at end of file
@@ -1,6 +1,10 @@
 #ifndef RENDER_VERTEX_H_
 #define RENDER_VERTEX_H_
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
 #include "math/math.h"
 #include "math/vector.h"
 #include "render/color.h"
@@ -13,6 +17,9 @@ struct Vertex {
   Color color;
 };
 
+// User varyings a vertex can carry, four floats each.
+inline constexpr std::size_t UserVaryingCount = 2;
+
 struct VertexOutput {
   v4f position;
   v3f normal;
@@ -20,6 +27,105 @@ struct VertexOutput {
   Color color;
 };
 
+// The user varyings of one vertex. They are kept out of line, in a stream
+// parallel to the VertexOutputs, which is only filled for shaders that read
+// them.
+using UserVaryings = std::array<v4f, UserVaryingCount>;
+
+// Set of the VertexOutput attributes a fragment shader reads. Only those are
+// clipped and interpolated; the others reach the shader zeroed.
+using VaryingMask = uint32_t;
+
+namespace varyings {
+inline constexpr VaryingMask None = 0;
+inline constexpr VaryingMask Normal = 1u << 0;
+inline constexpr VaryingMask Uv = 1u << 1;
+inline constexpr VaryingMask Color = 1u << 2;
+inline constexpr VaryingMask User0 = 1u << 3;
+inline constexpr VaryingMask User1 = 1u << 4;
+inline constexpr VaryingMask User = User0 | User1;
+
+// Read by shaders that do not declare their varyings.
+inline constexpr VaryingMask Default = Normal | Uv | Color;
+}  // namespace varyings
+
+constexpr std::size_t VaryingFloatCount(VaryingMask mask) {
+  std::size_t count{};
+  count += (mask & varyings::Normal) ? 3 : 0;
+  count += (mask & varyings::Uv) ? 2 : 0;
+  count += (mask & varyings::Color) ? 4 : 0;
+  count += (mask & varyings::User0) ? 4 : 0;
+  count += (mask & varyings::User1) ? 4 : 0;
+  return count;
+}
+
+// Screen-space rate of change of each VertexOutput attribute.
+struct VertexDerivative {
+  v4f position;
+  v3f normal;
+  v2f uv;
+  v4f color;
+  std::array<v4f, UserVaryingCount> user;
+};
+
+// Writes the attributes in Mask of v and its user varyings to out, packed
+// from index first on. user may be null when Mask has no user varyings.
+template <VaryingMask Mask, std::size_t N>
+constexpr void StoreVaryings(const VertexOutput& v, const UserVaryings* user,
+                             vec<float, N>& out, std::size_t first) {
+  static_assert(VaryingFloatCount(Mask) <= N);
+  std::size_t i = first;
+  auto store = [&]<std::size_t M>(vec<float, M> attribute) {
+    for (std::size_t k = 0; k < M; ++k) {
+      out[i++] = attribute[k];
+    }
+  };
+
+  if constexpr ((Mask & varyings::Normal) != 0) {
+    store(v.normal);
+  }
+  if constexpr ((Mask & varyings::Uv) != 0) {
+    store(v.uv);
+  }
+  if constexpr ((Mask & varyings::Color) != 0) {
+    store(v4f{v.color});
+  }
+  if constexpr ((Mask & varyings::User0) != 0) {
+    store((*user)[0]);
+  }
+  if constexpr ((Mask & varyings::User1) != 0) {
+    store((*user)[1]);
+  }
+}
+
+// Reads the attributes in Mask back from in into a VertexDerivative.
+template <VaryingMask Mask, std::size_t N>
+constexpr void LoadVaryings(VertexDerivative& v, const vec<float, N>& in,
+                            std::size_t first) {
+  std::size_t i = first;
+  auto load = [&]<std::size_t M>(vec<float, M>& attribute) {
+    for (std::size_t k = 0; k < M; ++k) {
+      attribute[k] = in[i++];
+    }
+  };
+
+  if constexpr ((Mask & varyings::Normal) != 0) {
+    load(v.normal);
+  }
+  if constexpr ((Mask & varyings::Uv) != 0) {
+    load(v.uv);
+  }
+  if constexpr ((Mask & varyings::Color) != 0) {
+    load(v.color);
+  }
+  if constexpr ((Mask & varyings::User0) != 0) {
+    load(v.user[0]);
+  }
+  if constexpr ((Mask & varyings::User1) != 0) {
+    load(v.user[1]);
+  }
+}
+
 constexpr Vertex lerp(Vertex v0, Vertex v1, float t) {
   Vertex v{};
   v.position = lerp(v0.position, v1.position, t);
@@ -29,15 +135,35 @@ constexpr Vertex lerp(Vertex v0, Vertex v1, float t) {
   return v;
 }
 
-constexpr VertexOutput lerp(VertexOutput v0, VertexOutput v1, float t) {
+// Interpolates the position and the attributes in mask; others are zeroed.
+constexpr VertexOutput lerp(const VertexOutput& v0, const VertexOutput& v1,
+                            float t, VaryingMask mask = varyings::Default) {
   VertexOutput v{};
   v.position = lerp(v0.position, v1.position, t);
-  v.normal = lerp(v0.normal, v1.normal, t);
-  v.uv = lerp(v0.uv, v1.uv, t);
-  v.color = lerp(v0.color, v1.color, t);
+  if (mask & varyings::Normal) {
+    v.normal = lerp(v0.normal, v1.normal, t);
+  }
+  if (mask & varyings::Uv) {
+    v.uv = lerp(v0.uv, v1.uv, t);
+  }
+  if (mask & varyings::Color) {
+    v.color = Color{lerp(v4f{v0.color}, v4f{v1.color}, t)};
+  }
   return v;
 }
 
+// Interpolates the user varyings in mask; others are zeroed.
+constexpr UserVaryings lerp(const UserVaryings& u0, const UserVaryings& u1,
+                            float t, VaryingMask mask) {
+  UserVaryings u{};
+  for (std::size_t i = 0; i < UserVaryingCount; ++i) {
+    if (mask & (varyings::User0 << i)) {
+      u[i] = lerp(u0[i], u1[i], t);
+    }
+  }
+  return u;
+}
+
 constexpr VertexOutput lerp(const VertexOutput& v0, const VertexOutput& v1,
                             const VertexOutput& v2, v3f b) {
   VertexOutput v{};
@@ -0,0 +1,39 @@
+#include "render/visibility_buffer.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "math/math.h"
+#include "render/buffer.h"
+
+namespace softy {
+VisibilityBuffer::VisibilityBuffer(int32_t width, int32_t height)
+    : buffer_{BitCount<uint32_t>(), static_cast<std::size_t>(width * height)},
+      width_{width},
+      height_{height} {}
+
+void VisibilityBuffer::SetSize(int32_t width, int32_t height) noexcept {
+  buffer_.Allocate(BitCount<uint32_t>(),
+                   static_cast<std::size_t>(width * height));
+  width_ = width;
+  height_ = height;
+}
+
+uint32_t VisibilityBuffer::GetId(int32_t x, int32_t y) {
+  assert(x >= 0 && x < width_ && y >= 0 && y < height_);
+  uint32_t* ids = buffer_.Get<uint32_t>();
+  return ids[y * width_ + x];
+}
+
+void VisibilityBuffer::SetId(int32_t x, int32_t y, uint32_t id) {
+  assert(x >= 0 && x < width_ && y >= 0 && y < height_);
+  uint32_t* ids = buffer_.Get<uint32_t>();
+  ids[y * width_ + x] = id;
+}
+
+void VisibilityBuffer::Clear() {
+  std::size_t n = static_cast<std::size_t>(width_ * height_);
+  StreamFill(buffer_.Get<uint32_t>(), n, EmptyVisibility);
+}
+}  // namespace softy
\ No newline at end of file
@@ -0,0 +1,73 @@
+#ifndef RENDER_VISIBILITY_BUFFER_H_
+#define RENDER_VISIBILITY_BUFFER_H_
+
+#include <cstdint>
+
+#include "render/buffer.h"
+
+namespace softy {
+// A visibility id packs the draw in its top bits and the draw's binned
+// triangle below them.
+inline constexpr uint32_t VisibilityDrawBits = 10;
+inline constexpr uint32_t VisibilityTriangleBits = 32 - VisibilityDrawBits;
+inline constexpr uint32_t MaxVisibilityDraws = (1u << VisibilityDrawBits) - 1;
+inline constexpr uint32_t MaxVisibilityTriangles = 1u
+                                                   << VisibilityTriangleBits;
+// Pixels no triangle covers. Draw MaxVisibilityDraws is never used.
+inline constexpr uint32_t EmptyVisibility = ~0u;
+
+constexpr uint32_t MakeVisibilityId(uint32_t draw, uint32_t triangle) {
+  return (draw << VisibilityTriangleBits) | triangle;
+}
+
+constexpr uint32_t GetVisibilityDraw(uint32_t id) {
+  return id >> VisibilityTriangleBits;
+}
+
+constexpr uint32_t GetVisibilityTriangle(uint32_t id) {
+  return id & (MaxVisibilityTriangles - 1);
+}
+
+class VisibilityBuffer {
+ public:
+  VisibilityBuffer() = default;
+  VisibilityBuffer(int32_t width, int32_t height);
+  ~VisibilityBuffer() = default;
+
+  void SetSize(int32_t width, int32_t height) noexcept;
+
+  int32_t GetWidth() const noexcept { return width_; }
+  int32_t GetHeight() const noexcept { return height_; }
+  Buffer& GetData() noexcept { return buffer_; }
+
+  uint32_t GetId(int32_t x, int32_t y);
+  void SetId(int32_t x, int32_t y, uint32_t id);
+  // Marks every pixel empty.
+  void Clear();
+
+ private:
+  Buffer buffer_;
+  int32_t width_{};
+  int32_t height_{};
+};
+
+// Render target of a visibility pass: the ids of the triangles of one draw.
+struct VisibilityTarget {
+  VisibilityBuffer* buffer;
+  uint32_t draw;
+
+  int32_t GetWidth() const noexcept { return buffer->GetWidth(); }
+  int32_t GetHeight() const noexcept { return buffer->GetHeight(); }
+};
+
+// Pixels of a 2x2 quad at (x, y) covered by the triangle with visibility id
+// id, one bit per pixel as in QuadMask.
+struct VisibleQuad {
+  uint32_t id;
+  int32_t x;
+  int32_t y;
+  uint32_t mask;
+};
+}  // namespace softy
+
+#endif  // RENDER_VISIBILITY_BUFFER_H_
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "render/visibility_render_pipeline.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include "core/frame_arena.h"
+#include "core/thread_pool.h"
+#include "math/math.h"
+#include "render/buffer.h"
+#include "render/camera.h"
+#include "render/clipper.h"
+#include "render/material.h"
+#include "render/mesh.h"
+#include "render/pipeline_state.h"
+#include "render/triangle_setup.h"
+#include "render/visibility_buffer.h"
+
+namespace softy {
+void VisibilityRenderPipeline::RenderFrame(Camera* camera) {
+  ConstantBuffer* cb = GetConstantBuffer();
+  ColorBuffer* rt = camera->GetRenderTarget();
+  DepthBuffer* db = camera->GetDepthTarget();
+  assert(db != nullptr && "Visibility rendering needs a depth target");
+
+  if (visibility_.GetWidth() != rt->GetWidth() ||
+      visibility_.GetHeight() != rt->GetHeight()) {
+    visibility_.SetSize(rt->GetWidth(), rt->GetHeight());
+  }
+  visibility_.Clear();
+
+  FrameVector<VertexOutput> vsOutputs;
+  FrameVector<UserVaryings> userOutputs;
+  draws_.reserve(min(meshes_.size(), std::size_t{MaxVisibilityDraws}));
+
+  // Every binned triangle of a draw needs its own id, and clipping can split
+  // one triangle into MaxClippedTriangles.
+  constexpr std::size_t maxDrawIndices =
+      MaxVisibilityTriangles / MaxClippedTriangles * 3;
+
+  auto draw = [&](const PipelineState* pipelineState,
+                  const std::vector<Vertex>& vertices,
+                  std::span<const int32_t> indices) {
+    // Once the ids run out, the draws so far are shaded and the visibility
+    // buffer starts over. Depth carries over, so later draws stay occluded.
+    if (draws_.size() == MaxVisibilityDraws) {
+      ResolvePass(rt);
+      draws_.clear();
+      visibility_.Clear();
+    }
+
+    if (constants_.size() == draws_.size()) {
+      constants_.emplace_back();
+    }
+    constants_[draws_.size()] = *cb;
+
+    VisibilityTarget target{.buffer = &visibility_,
+                            .draw = static_cast<uint32_t>(draws_.size())};
+    draws_.push_back(Draw{
+        .pipelineState = pipelineState,
+        .binned = pipelineState->DrawVisibility(
+            *cb, target, db, vertices, indices, vsOutputs, userOutputs),
+    });
+  };
+
+  for (auto [mesh, transform] : std::views::zip(meshes_, transforms_)) {
+    const Material* material = mesh->GetMaterial();
+    const std::vector<int32_t>& indices = mesh->GetIndices();
+
+    cb->SetWorldMatrix(transform);
+    cb->SetProperties(material->GetProperties());
+    // Meshes too large for one draw are split, which transforms their
+    // vertices once per part.
+    std::span<const int32_t> remaining{indices};
+    while (!remaining.empty()) {
+      std::size_t count = min(maxDrawIndices, remaining.size());
+      draw(material->GetPipelineState(), mesh->GetVertices(),
+           remaining.first(count));
+      remaining = remaining.subspan(count);
+    }
+  }
+
+  ResolvePass(rt);
+
+  draws_.clear();
+}
+
+void VisibilityRenderPipeline::ResolvePass(ColorBuffer* renderTarget) {
+  int32_t width = visibility_.GetWidth();
+  int32_t height = visibility_.GetHeight();
+  int32_t tileCountX = (width + TileSize - 1) / TileSize;
+  int32_t tileCountY = (height + TileSize - 1) / TileSize;
+  const uint32_t* ids = visibility_.GetData().Get<uint32_t>();
+
+  ThreadPool::Instance().ParallelFor(
+      static_cast<std::size_t>(tileCountX * tileCountY),
+      [&](std::size_t tileIndex) {
+        auto index = static_cast<int32_t>(tileIndex);
+        int32_t xMin = index % tileCountX * TileSize;
+        int32_t yMin = index / tileCountX * TileSize;
+        int32_t xMax = min(xMin + TileSize, width);
+        int32_t yMax = min(yMin + TileSize, height);
+
+        // Split every quad by the triangles it shows, then group the
+        // pieces by draw and triangle.
+        FrameVector<VisibleQuad> quads;
+        for (int32_t y = yMin; y < yMax; y += 2) {
+          for (int32_t x = xMin; x < xMax; x += 2) {
+            std::array<uint32_t, 4> lanes{};
+            for (int32_t i = 0; i < 4; ++i) {
+              int32_t px = x + (i & 1);
+              int32_t py = y + (i >> 1);
+              lanes[static_cast<std::size_t>(i)] =
+                  px < xMax && py < yMax ? ids[py * width + px]
+                                         : EmptyVisibility;
+            }
+
+            uint32_t remaining = 0xF;
+            while (remaining != 0) {
+              auto first = static_cast<std::size_t>(
+                  std::countr_zero(remaining));
+              uint32_t id = lanes[first];
+              uint32_t mask{};
+              for (uint32_t bits = remaining; bits != 0; bits &= bits - 1) {
+                auto i = static_cast<std::size_t>(std::countr_zero(bits));
+                if (lanes[i] == id) {
+                  mask |= 1u << i;
+                }
+              }
+              remaining &= ~mask;
+              if (id != EmptyVisibility) {
+                quads.push_back(
+                    VisibleQuad{.id = id, .x = x, .y = y, .mask = mask});
+              }
+            }
+          }
+        }
+
+        if (quads.empty()) {
+          return;
+        }
+
+        renderTarget->ResolveTile(tileIndex);
+        std::ranges::sort(quads, {}, &VisibleQuad::id);
+        std::span<const VisibleQuad> pending{quads};
+        while (!pending.empty()) {
+          uint32_t draw = GetVisibilityDraw(pending.front().id);
+          std::size_t count = 1;
+          while (count < pending.size() &&
+                 GetVisibilityDraw(pending[count].id) == draw) {
+            ++count;
+          }
+
+          const Draw& d = draws_[draw];
+          d.pipelineState->Resolve(constants_[draw], *renderTarget, d.binned,
+                                   pending.first(count));
+          pending = pending.subspan(count);
+        }
+      });
+}
+}  // namespace softy
\ No newline at end of file
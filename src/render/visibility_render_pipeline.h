@@ -0,0 +1,42 @@
+#ifndef RENDER_VISIBILITY_RENDER_PIPELINE_H_
+#define RENDER_VISIBILITY_RENDER_PIPELINE_H_
+
+#include <vector>
+
+#include "render/buffer.h"
+#include "render/camera.h"
+#include "render/pipeline_state.h"
+#include "render/render_pipeline.h"
+#include "render/triangle_setup.h"
+#include "render/visibility_buffer.h"
+
+namespace softy {
+// Rasterizes only depth and visibility ids, then shades each visible pixel
+// once, reconstructing its attributes from the triangle it shows. Blend
+// modes do not apply; every draw is opaque.
+class VisibilityRenderPipeline : public RenderPipeline {
+ public:
+  VisibilityRenderPipeline() = default;
+  virtual ~VisibilityRenderPipeline() = default;
+
+ protected:
+  // The camera must have a depth target.
+  virtual void RenderFrame(Camera* camera) override;
+
+ private:
+  // What a draw's visibility ids refer to, kept until it is resolved.
+  struct Draw {
+    const PipelineState* pipelineState;
+    BinnedTriangles binned;
+  };
+
+  void ResolvePass(ColorBuffer* renderTarget);
+
+  VisibilityBuffer visibility_;
+  std::vector<Draw> draws_;
+  // Constants of draw i, kept across frames so that their blocks are reused.
+  std::vector<ConstantBuffer> constants_;
+};
+}  // namespace softy
+
+#endif  // RENDER_VISIBILITY_RENDER_PIPELINE_H_
\ No newline at end of file
@@ -0,0 +1,121 @@
+#ifndef SHADER_FRAGMENT_H_
+#define SHADER_FRAGMENT_H_
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "math/vector.h"
+#include "render/buffer.h"
+#include "render/color.h"
+#include "render/vertex.h"
+
+namespace softy {
+// A pixel's attributes and their derivatives, taken as differences across
+// the pixel's 2x2 quad. Uncovered pixels of the quad take part as helpers.
+struct Fragment {
+  VertexOutput v;
+  UserVaryings user;
+  VertexDerivative ddx;
+  VertexDerivative ddy;
+};
+
+// Fragments a packet shader processes at once: one 2x2 quad.
+inline constexpr std::size_t PacketSize = 4;
+
+// One float per fragment of a packet.
+using Lanes = vec<float, PacketSize>;
+
+// The fragments of a 2x2 quad in SoA form, lane (dy * 2 + dx). Only lanes
+// set in mask are written; the others are helpers.
+struct FragmentPacket {
+  std::array<Lanes, 4> position;
+  std::array<Lanes, 3> normal;
+  std::array<Lanes, 2> uv;
+  std::array<Lanes, 4> color;
+  std::array<std::array<Lanes, 4>, UserVaryingCount> user;
+  VertexDerivative ddx;
+  VertexDerivative ddy;
+  uint32_t mask;
+};
+
+using PacketColor = std::array<Color, PacketSize>;
+
+// A single lane of packet, with the varyings in Mask.
+template <VaryingMask Mask>
+Fragment GetFragment(const FragmentPacket& packet, std::size_t lane) {
+  auto get = [lane]<std::size_t M>(const std::array<Lanes, M>& lanes) {
+    vec<float, M> v{};
+    for (std::size_t k = 0; k < M; ++k) {
+      v[k] = lanes[k][lane];
+    }
+    return v;
+  };
+
+  Fragment f{.v = {}, .user = {}, .ddx = packet.ddx, .ddy = packet.ddy};
+  f.v.position = get(packet.position);
+  if constexpr ((Mask & varyings::Normal) != 0) {
+    f.v.normal = get(packet.normal);
+  }
+  if constexpr ((Mask & varyings::Uv) != 0) {
+    f.v.uv = get(packet.uv);
+  }
+  if constexpr ((Mask & varyings::Color) != 0) {
+    f.v.color = Color{get(packet.color)};
+  }
+  if constexpr ((Mask & varyings::User0) != 0) {
+    f.user[0] = get(packet.user[0]);
+  }
+  if constexpr ((Mask & varyings::User1) != 0) {
+    f.user[1] = get(packet.user[1]);
+  }
+  return f;
+}
+
+using FragmentShader =
+    std::function<Color(const ConstantBuffer&, const Fragment&)>;
+
+// Shades one fragment at a time.
+template <typename T>
+concept PixelFragmentProgram =
+    requires(const T& fs, const ConstantBuffer& cb, const Fragment& f) {
+      { fs(cb, f) } -> std::convertible_to<Color>;
+    };
+
+// Shades a whole packet at once. Preferred when a shader offers both.
+template <typename T>
+concept PacketFragmentProgram =
+    requires(const T& fs, const ConstantBuffer& cb, const FragmentPacket& p) {
+      { fs(cb, p) } -> std::convertible_to<PacketColor>;
+    };
+
+template <typename T>
+concept FragmentProgram = PixelFragmentProgram<T> || PacketFragmentProgram<T>;
+
+// A fragment program that declares the varyings it reads.
+template <VaryingMask Mask, typename FS>
+struct VaryingDeclaration : FS {
+  static constexpr VaryingMask Varyings = Mask;
+};
+
+template <VaryingMask Mask, FragmentProgram FS>
+  requires std::is_class_v<FS>
+constexpr VaryingDeclaration<Mask, FS> DeclareVaryings(FS fs) {
+  return VaryingDeclaration<Mask, FS>{std::move(fs)};
+}
+
+template <FragmentProgram FS>
+constexpr VaryingMask GetVaryingMask() {
+  if constexpr (requires { FS::Varyings; }) {
+    return FS::Varyings;
+  } else {
+    return varyings::Default;
+  }
+}
+}  // namespace softy
+
+#endif  // SHADER_FRAGMENT_H_
\ No newline at end of file
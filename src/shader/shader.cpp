@@ -1,36 +1,156 @@
 #include "shader/shader.h"
 
-#include <any>
+#include <array>
+#include <cstddef>
+#include <span>
+#include <utility>
+
+#include "math/matrix.h"
+#include "math/vector.h"
+#include "render/property_block.h"
+#include "render/sampler.h"
+#include "render/texture.h"
 
 namespace softy {
-VertexOutput softy::DefaultVertexShader(const ConstantBuffer& cb,
-                                        const Vertex& vertex) {
-  VertexOutput output;
+// Vertices whose positions are transformed together, one lane each.
+static constexpr std::size_t VertexBatchSize = 8;
+
+using VertexLanes = vec<float, VertexBatchSize>;
+
+void DefaultVertexShader(const ConstantBuffer& cb,
+                         std::span<const Vertex> vertices,
+                         std::span<VertexOutput> outputs) {
+  mat4 mvp = cb.GetWorldMatrix() * cb.GetViewMatrix() *
+             cb.GetProjectionMatrix();
+
+  std::size_t i = 0;
+  for (; i + VertexBatchSize <= vertices.size(); i += VertexBatchSize) {
+    std::array<VertexLanes, 4> in{};
+    for (std::size_t lane = 0; lane < VertexBatchSize; ++lane) {
+      for (std::size_t c = 0; c < 4; ++c) {
+        in[c][lane] = vertices[i + lane].position[c];
+      }
+    }
+
+    std::array<VertexLanes, 4> out{};
+    for (std::size_t c = 0; c < 4; ++c) {
+      out[c] = in[0] * mvp[0][c] + in[1] * mvp[1][c] + in[2] * mvp[2][c] +
+               in[3] * mvp[3][c];
+    }
 
-  output.position = vertex.position * cb.GetWorldMatrix() * cb.GetViewMatrix() *
-                    cb.GetProjectionMatrix();
-  output.normal = vertex.normal;
-  output.uv = vertex.uv;
-  output.color = vertex.color;
+    for (std::size_t lane = 0; lane < VertexBatchSize; ++lane) {
+      outputs[i + lane].position =
+          v4f{out[0][lane], out[1][lane], out[2][lane], out[3][lane]};
+    }
+  }
 
-  return output;
+  for (; i < vertices.size(); ++i) {
+    outputs[i].position = vertices[i].position * mvp;
+  }
+
+  // Normals go to world space, which assumes uniform scaling.
+  const mat4& world = cb.GetWorldMatrix();
+  for (std::size_t j = 0; j < vertices.size(); ++j) {
+    outputs[j].normal = v3f{v4f{vertices[j].normal, 0.0f} * world};
+    outputs[j].uv = vertices[j].uv;
+    outputs[j].color = vertices[j].color;
+  }
 }
 
-Color UvColorFragmentShader(const ConstantBuffer& cb, const VertexOutput& v) {
-  return Color{v.uv[0], v.uv[1], 0.0f};
+PacketColor UvColorFragmentShader(const ConstantBuffer&,
+                                  const FragmentPacket& p) {
+  PacketColor colors{};
+  for (std::size_t i = 0; i < PacketSize; ++i) {
+    colors[i] = Color{p.uv[0][i], p.uv[1][i], 0.0f};
+  }
+  return colors;
 }
 
-Color VertexColorFragmentShader(const ConstantBuffer& cb,
-                                const VertexOutput& v) {
-  return v.color * std::any_cast<Color>(cb.GetProperties()->at("Color_"));
+PacketColor VertexColorFragmentShader(const ConstantBuffer& cb,
+                                      const FragmentPacket& p,
+                                      PropertySlot<Color> color) {
+  Color tint = cb.GetProperties()->Get(color);
+  PacketColor colors{};
+  for (std::size_t i = 0; i < PacketSize; ++i) {
+    colors[i] = Color{v4f{p.color[0][i], p.color[1][i], p.color[2][i],
+                          p.color[3][i]}} *
+                tint;
+  }
+  return colors;
 }
 
-Color UnlitColorFragmentShader(const ConstantBuffer& cb,
-                               const VertexOutput& v) {
-  return std::any_cast<Color>(cb.GetProperties()->at("Color_"));
+PacketColor UnlitColorFragmentShader(const ConstantBuffer& cb,
+                                     const FragmentPacket&,
+                                     PropertySlot<Color> color) {
+  PacketColor colors{};
+  colors.fill(cb.GetProperties()->Get(color));
+  return colors;
 }
 
-Shader UvColorShader() { return Shader(UvColorFragmentShader); }
-Shader VertexColorShader() { return Shader(VertexColorFragmentShader); }
-Shader UnlitColorShader() { return Shader(UnlitColorFragmentShader); }
+PacketColor TextureFragmentShader(const ConstantBuffer& cb,
+                                  const FragmentPacket& p,
+                                  PropertySlot<const Texture2D*> texture,
+                                  PropertySlot<Sampler> sampler) {
+  const PropertyBlock* properties = cb.GetProperties();
+  const Texture2D* tex = properties->Get(texture);
+  PacketColor colors{};
+  if (tex == nullptr) {
+    colors.fill(Color::White());
+    return colors;
+  }
+
+  TexelPacket texels = Sample(*tex, properties->Get(sampler), p);
+  for (std::size_t i = 0; i < PacketSize; ++i) {
+    colors[i] = Color{
+        v4f{texels[0][i], texels[1][i], texels[2][i], texels[3][i]}};
+  }
+  return colors;
+}
+
+// Lambdas give every built-in shader its own type, and with it a rasterizer
+// that calls the fragment shader directly.
+Shader UvColorShader() {
+  return Shader(DeclareVaryings<varyings::Uv>(
+      [](const ConstantBuffer& cb, const FragmentPacket& p) {
+        return UvColorFragmentShader(cb, p);
+      }));
+}
+
+Shader VertexColorShader() {
+  PropertyLayout layout;
+  PropertySlot<Color> color = layout.Add<Color>("Color_");
+
+  Shader shader(DeclareVaryings<varyings::Color>(
+      [color](const ConstantBuffer& cb, const FragmentPacket& p) {
+        return VertexColorFragmentShader(cb, p, color);
+      }));
+  shader.SetPropertyLayout(std::move(layout));
+  return shader;
+}
+
+Shader UnlitColorShader() {
+  PropertyLayout layout;
+  PropertySlot<Color> color = layout.Add<Color>("Color_");
+
+  Shader shader(DeclareVaryings<varyings::None>(
+      [color](const ConstantBuffer& cb, const FragmentPacket& p) {
+        return UnlitColorFragmentShader(cb, p, color);
+      }));
+  shader.SetPropertyLayout(std::move(layout));
+  return shader;
+}
+
+Shader TextureShader() {
+  PropertyLayout layout;
+  PropertySlot<const Texture2D*> texture =
+      layout.Add<const Texture2D*>("Texture_");
+  PropertySlot<Sampler> sampler = layout.Add<Sampler>("Sampler_");
+
+  Shader shader(DeclareVaryings<varyings::Uv>(
+      [texture, sampler](const ConstantBuffer& cb, const FragmentPacket& p) {
+        return TextureFragmentShader(cb, p, texture, sampler);
+      }));
+  shader.SetPropertyLayout(std::move(layout));
+  return shader;
+}
 }  // namespace softy
\ No newline at end of file
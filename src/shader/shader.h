@@ -1,38 +1,255 @@
 #ifndef SHADER_SHADER_H_
 #define SHADER_SHADER_H_
 
+#include <any>
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <span>
+#include <utility>
 #include <vector>
 
+#include "core/frame_arena.h"
 #include "render/buffer.h"
 #include "render/color.h"
+#include "render/gbuffer.h"
+#include "render/property_block.h"
+#include "render/rasterizer.h"
+#include "render/render_state.h"
+#include "render/triangle_setup.h"
 #include "render/vertex.h"
+#include "render/visibility_buffer.h"
+#include "shader/fragment.h"
 
 namespace softy {
 using VertexShader =
     std::function<VertexOutput(const ConstantBuffer&, const Vertex&)>;
-using FragmentShader =
-    std::function<Color(const ConstantBuffer&, const VertexOutput&)>;
 
-VertexOutput DefaultVertexShader(const ConstantBuffer& cb,
-                                 const Vertex& vertex);
+// Transforms one vertex at a time.
+template <typename T>
+concept SingleVertexProgram =
+    requires(const T& vs, const ConstantBuffer& cb, const Vertex& v) {
+      { vs(cb, v) } -> std::convertible_to<VertexOutput>;
+    };
+
+// Transforms all vertices of a draw at once. Preferred when a shader offers
+// both.
+template <typename T>
+concept BatchVertexProgram =
+    requires(const T& vs, const ConstantBuffer& cb,
+             std::span<const Vertex> vertices,
+             std::span<VertexOutput> outputs) { vs(cb, vertices, outputs); };
+
+// A batch program that also writes the user varyings of every vertex.
+template <typename T>
+concept UserVertexProgram =
+    requires(const T& vs, const ConstantBuffer& cb,
+             std::span<const Vertex> vertices, std::span<VertexOutput> outputs,
+             std::span<UserVaryings> user) { vs(cb, vertices, outputs, user); };
+
+template <typename T>
+concept VertexProgram =
+    SingleVertexProgram<T> || BatchVertexProgram<T> || UserVertexProgram<T>;
+
+// Concatenates the MVP matrix once and transforms positions in SoA batches.
+// Normals are transformed to world space.
+void DefaultVertexShader(const ConstantBuffer& cb,
+                         std::span<const Vertex> vertices,
+                         std::span<VertexOutput> outputs);
 
 class Shader {
  public:
-  Shader(VertexShader vs, FragmentShader fs) : vs_{vs}, fs_{fs} {}
-  Shader(FragmentShader fs) : vs_{DefaultVertexShader}, fs_{fs} {}
+  // Shader types known at compile time get their own vertex loop and
+  // rasterizer, so they are called directly from the inner loops. Passing
+  // std::functions selects the type-erased fallback.
+  template <VertexProgram VS, FragmentProgram FS>
+  Shader(VS vs, FS fs)
+      : vs_{std::move(vs)},
+        fs_{std::move(fs)},
+        processVertices_{&ProcessVerticesImpl<VS>},
+        rasterStages_{&RasterStages<FS>},
+        geometryStages_{&GeometryStages<FS>},
+        resolve_{&ResolveImpl<FS>},
+        varyings_{GetVaryingMask<FS>()} {}
+  template <FragmentProgram FS>
+  Shader(FS fs)
+      : Shader(
+            [](const ConstantBuffer& cb, std::span<const Vertex> vertices,
+               std::span<VertexOutput> outputs) {
+              DefaultVertexShader(cb, vertices, outputs);
+            },
+            fs) {}
+
+  // Properties the shader reads, in the order materials pack them.
+  const PropertyLayout& GetPropertyLayout() const noexcept {
+    return propertyLayout_;
+  }
+
+  void SetPropertyLayout(PropertyLayout layout) {
+    propertyLayout_ = std::move(layout);
+  }
+
+  // user is left empty unless the vertex program writes user varyings or
+  // the fragment program reads them.
+  void ProcessVertices(const ConstantBuffer& cb,
+                       const std::vector<Vertex>& vertices,
+                       FrameVector<VertexOutput>& outputs,
+                       FrameVector<UserVaryings>& user) const {
+    processVertices_(*this, cb, vertices, outputs, user);
+  }
+
+  using RasterStage = void (*)(const Shader&, const ConstantBuffer&,
+                               ColorBuffer&, DepthBuffer*, CullMode,
+                               std::span<const VertexOutput>,
+                               std::span<const UserVaryings>,
+                               const std::vector<int>&);
+
+  using GeometryStage = void (*)(const Shader&, const ConstantBuffer&,
+                                 GBufferTarget&, DepthBuffer*, CullMode,
+                                 std::span<const VertexOutput>,
+                                 std::span<const UserVaryings>,
+                                 const std::vector<int>&);
+
+  // The rasterizer compiled for this shader's fragment program and state.
+  RasterStage GetRasterStage(RasterState state) const noexcept {
+    return (*rasterStages_)[GetRasterStateIndex(state)];
+  }
+
+  using ResolveStage = void (*)(const Shader&, const ConstantBuffer&,
+                                ColorBuffer&, const BinnedTriangles&,
+                                std::span<const VisibleQuad>);
+
+  // The rasterizer that writes this shader's output to a G-buffer.
+  GeometryStage GetGeometryStage(DepthState state) const noexcept {
+    return (*geometryStages_)[GetDepthStateIndex(state)];
+  }
+
+  // Shades quads of a visibility buffer with this shader.
+  ResolveStage GetResolveStage() const noexcept { return resolve_; }
+
+  // Varyings the fragment program reads.
+  VaryingMask GetVaryings() const noexcept { return varyings_; }
 
-  const VertexShader GetVS() const noexcept { return vs_; }
-  const FragmentShader GetFS() const noexcept { return fs_; }
+  // Unique among all shaders ever created, unlike their addresses.
+  uint64_t GetId() const noexcept { return id_.Get(); }
 
  private:
-  VertexShader vs_;
-  FragmentShader fs_;
+  // Every construction, copy, move and assignment draws a new id, so no two
+  // objects ever share one.
+  class Id {
+   public:
+    Id() noexcept : value_{Next()} {}
+    Id(const Id&) noexcept : value_{Next()} {}
+    Id& operator=(const Id&) noexcept {
+      value_ = Next();
+      return *this;
+    }
+
+    uint64_t Get() const noexcept { return value_; }
+
+   private:
+    static uint64_t Next() noexcept {
+      static std::atomic<uint64_t> next{1};
+      return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t value_;
+  };
+
+  using VertexStage = void (*)(const Shader&, const ConstantBuffer&,
+                               const std::vector<Vertex>&,
+                               FrameVector<VertexOutput>&,
+                               FrameVector<UserVaryings>&);
+  using RasterStageTable = std::array<RasterStage, RasterStateCount>;
+  using GeometryStageTable = std::array<GeometryStage, DepthStateCount>;
+
+  template <VertexProgram VS>
+  static void ProcessVerticesImpl(const Shader& shader,
+                                  const ConstantBuffer& cb,
+                                  const std::vector<Vertex>& vertices,
+                                  FrameVector<VertexOutput>& outputs,
+                                  FrameVector<UserVaryings>& user) {
+    const VS& vs = *std::any_cast<VS>(&shader.vs_);
+    outputs.resize(vertices.size());
+    user.clear();
+    if (UserVertexProgram<VS> || (shader.varyings_ & varyings::User) != 0) {
+      user.resize(vertices.size());
+    }
+
+    if constexpr (UserVertexProgram<VS>) {
+      vs(cb, std::span<const Vertex>{vertices},
+         std::span<VertexOutput>{outputs}, std::span<UserVaryings>{user});
+    } else if constexpr (BatchVertexProgram<VS>) {
+      vs(cb, std::span<const Vertex>{vertices},
+         std::span<VertexOutput>{outputs});
+    } else {
+      for (std::size_t i = 0; i < vertices.size(); ++i) {
+        outputs[i] = vs(cb, vertices[i]);
+      }
+    }
+  }
+
+  template <FragmentProgram FS, RasterState State, typename Target>
+  static void RasterizeImpl(const Shader& shader, const ConstantBuffer& cb,
+                            Target& renderTarget,
+                            DepthBuffer* depthTarget, CullMode cullMode,
+                            std::span<const VertexOutput> vsOutputs,
+                            std::span<const UserVaryings> user,
+                            const std::vector<int>& indices) {
+    softy::Rasterize<State>(cb, renderTarget, depthTarget, cullMode, vsOutputs,
+                            user, indices, *std::any_cast<FS>(&shader.fs_));
+  }
+
+  template <FragmentProgram FS>
+  static void ResolveImpl(const Shader& shader, const ConstantBuffer& cb,
+                          ColorBuffer& renderTarget,
+                          const BinnedTriangles& binned,
+                          std::span<const VisibleQuad> quads) {
+    softy::ResolveQuads(cb, renderTarget, binned, quads,
+                        *std::any_cast<FS>(&shader.fs_));
+  }
+
+  template <FragmentProgram FS, std::size_t... I>
+  static constexpr RasterStageTable MakeRasterStages(
+      std::index_sequence<I...>) {
+    return {&RasterizeImpl<FS, GetRasterState(I), ColorBuffer>...};
+  }
+
+  template <FragmentProgram FS, std::size_t... I>
+  static constexpr GeometryStageTable MakeGeometryStages(
+      std::index_sequence<I...>) {
+    return {&RasterizeImpl<FS, RasterState{.depth = GetDepthState(I)},
+                           GBufferTarget>...};
+  }
+
+  // One rasterizer per raster state, indexed by GetRasterStateIndex.
+  template <FragmentProgram FS>
+  static constexpr RasterStageTable RasterStages =
+      MakeRasterStages<FS>(std::make_index_sequence<RasterStateCount>{});
+
+  // One G-buffer rasterizer per depth state, indexed by GetDepthStateIndex.
+  template <FragmentProgram FS>
+  static constexpr GeometryStageTable GeometryStages =
+      MakeGeometryStages<FS>(std::make_index_sequence<DepthStateCount>{});
+
+  std::any vs_;
+  std::any fs_;
+  VertexStage processVertices_;
+  const RasterStageTable* rasterStages_;
+  const GeometryStageTable* geometryStages_;
+  ResolveStage resolve_;
+  VaryingMask varyings_;
+  PropertyLayout propertyLayout_;
+  Id id_;
 };
 
 Shader UvColorShader();
 Shader VertexColorShader();
 Shader UnlitColorShader();
+Shader TextureShader();
 }  // namespace softy
 
 #endif  // SHADER_SHADER_H_
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include "window/swap_chain.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "render/buffer.h"
+
+namespace softy {
+SwapChain::SwapChain(int32_t width, int32_t height, std::size_t bufferCount,
+                     BufferLayout layout, CopyFn copy, ShowFn show)
+    : busy_(bufferCount), copy_{std::move(copy)}, show_{std::move(show)} {
+  assert(bufferCount >= 2);
+  buffers_.reserve(bufferCount);
+  for (std::size_t i = 0; i < bufferCount; ++i) {
+    buffers_.push_back(std::make_unique<ColorBuffer>(width, height, layout));
+  }
+  thread_ = std::thread{[this]() { PresentLoop(); }};
+}
+
+SwapChain::~SwapChain() {
+  {
+    std::lock_guard lock{mutex_};
+    stop_ = true;
+  }
+  queued_.notify_one();
+  thread_.join();
+}
+
+ColorBuffer& SwapChain::Present() {
+  std::unique_lock lock{mutex_};
+  busy_[back_] = 1;
+  queue_.push_back(back_);
+  queued_.notify_one();
+
+  back_ = (back_ + 1) % buffers_.size();
+  released_.wait(lock, [this]() { return busy_[back_] == 0; });
+  return *buffers_[back_];
+}
+
+void SwapChain::PresentLoop() {
+  while (true) {
+    std::size_t index{};
+    {
+      std::unique_lock lock{mutex_};
+      queued_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      index = queue_.front();
+      queue_.pop_front();
+    }
+
+    copy_(*buffers_[index]);
+
+    {
+      std::lock_guard lock{mutex_};
+      busy_[index] = 0;
+    }
+    released_.notify_one();
+    show_();
+  }
+}
+}  // namespace softy
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef WINDOW_SWAP_CHAIN_H_
+#define WINDOW_SWAP_CHAIN_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "render/buffer.h"
+
+namespace softy {
+// Color buffers cycled between the renderer and a present thread, so a frame
+// is shown while the next one renders.
+class SwapChain {
+ public:
+  // Called on the present thread with each presented buffer, which goes
+  // back to the renderer as soon as it returns.
+  using CopyFn = std::function<void(ColorBuffer&)>;
+  // Called on the present thread after each copy, without a buffer.
+  using ShowFn = std::function<void()>;
+
+  SwapChain(int32_t width, int32_t height, std::size_t bufferCount,
+            BufferLayout layout, CopyFn copy, ShowFn show);
+  ~SwapChain();
+  SwapChain(const SwapChain&) = delete;
+  SwapChain& operator=(const SwapChain&) = delete;
+  SwapChain(SwapChain&&) = delete;
+  SwapChain& operator=(SwapChain&&) = delete;
+
+  ColorBuffer& GetBackBuffer() noexcept { return *buffers_[back_]; }
+
+  // Queues the back buffer for presenting and returns the next one, waiting
+  // only while that one is still queued or being copied.
+  ColorBuffer& Present();
+
+ private:
+  void PresentLoop();
+
+  std::vector<std::unique_ptr<ColorBuffer>> buffers_;
+  std::vector<uint8_t> busy_;
+  std::size_t back_{};
+  CopyFn copy_;
+  ShowFn show_;
+
+  std::mutex mutex_;
+  std::condition_variable queued_;
+  std::condition_variable released_;
+  std::deque<std::size_t> queue_;
+  bool stop_{false};
+  std::thread thread_;
+};
+}  // namespace softy
+
+#endif  // WINDOW_SWAP_CHAIN_H_
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef WINDOW_WINDOW_H_
 #define WINDOW_WINDOW_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -15,6 +16,11 @@ struct WindowDescriptor {
   std::string name;
   int32_t width;
   int32_t height;
+  // Back buffers are scaled to the window when presented.
+  int32_t bufferWidth;
+  int32_t bufferHeight;
+  std::size_t bufferCount{2};
+  BufferLayout bufferLayout{BufferLayout::Linear};
 };
 
 class Window {
@@ -26,10 +32,13 @@ class Window {
   Window(Window&&) = delete;
   Window& operator=(Window&&) = delete;
 
-  bool Create(WindowDescriptor& descriptor, EventChannel& eventChannel,
-              ColorBuffer& colorBuffer);
+  bool Create(WindowDescriptor& descriptor, EventChannel& eventChannel);
   bool Update();
-  void Present();
+
+  // The buffer to render the next frame into.
+  ColorBuffer& GetBackBuffer();
+  // Hands the back buffer to the present thread and returns the next one.
+  ColorBuffer& Present();
   void SetTitle(std::string_view title);
 
  private:
@@ -3,12 +3,16 @@
 #include "input/keycode.h"
 #include "render/buffer.h"
 #include "render/color.h"
+#include "window/swap_chain.h"
 #include "window/window.h"
 
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
 
+#include <cstddef>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace softy {
 static KeyCode GetKeyCode(WPARAM virtualKey);
@@ -18,22 +22,39 @@ struct Window::Impl {
   static LRESULT CALLBACK s_WndProc(HWND hwnd, uint32_t msg, WPARAM wparam,
                                     LPARAM lparam);
 
+  // The swap chain's copy and show steps, run on the present thread.
+  void CopyBuffer(ColorBuffer& buffer);
+  void ShowFront();
+  // Also runs on WM_PAINT.
+  void BlitFront(HDC hdc);
+  // Stretches row-major pixels over the window. frontMutex must be held.
+  void Blit(HDC hdc, const Color* pixels, int32_t width, int32_t height);
+
   WindowDescriptor& descriptor;
   EventChannel& channel;
-  ColorBuffer& colorBuffer;
   HWND hwnd;
+  // Row-major copy of the last presented tiled frame, so repainting never
+  // reads a buffer the renderer owns again. Linear frames are blitted
+  // straight from their buffer instead and leave it empty. Also guards
+  // descriptor's size.
+  std::mutex frontMutex;
+  std::vector<Color> front;
+  int32_t frontWidth;
+  int32_t frontHeight;
+  // Last, so the present thread stops before the members it uses go away.
+  std::unique_ptr<SwapChain> swapChain;
 };
 
 Window::Window() = default;
 Window::~Window() {
   if (impl_) {
+    impl_->swapChain.reset();
     UnregisterClassA(impl_->descriptor.name.c_str(), nullptr);
   }
 }
 
-bool Window::Create(WindowDescriptor& descriptor, EventChannel& channel,
-                    ColorBuffer& colorBuffer) {
-  impl_ = std::make_unique<Impl>(descriptor, channel, colorBuffer);
+bool Window::Create(WindowDescriptor& descriptor, EventChannel& channel) {
+  impl_ = std::make_unique<Impl>(descriptor, channel);
 
   const WNDCLASSEXA wc{
       .cbSize = sizeof(WNDCLASSEXA),
@@ -67,6 +88,12 @@ bool Window::Create(WindowDescriptor& descriptor, EventChannel& channel,
     return false;
   }
 
+  impl_->swapChain = std::make_unique<SwapChain>(
+      descriptor.bufferWidth, descriptor.bufferHeight, descriptor.bufferCount,
+      descriptor.bufferLayout,
+      [impl = impl_.get()](ColorBuffer& buffer) { impl->CopyBuffer(buffer); },
+      [impl = impl_.get()]() { impl->ShowFront(); });
+
   ShowWindow(impl_->hwnd, SW_SHOWDEFAULT);
   return true;
 }
@@ -85,11 +112,12 @@ bool Window::Update() {
   return true;
 }
 
-void Window::Present() {
-  InvalidateRect(impl_->hwnd, nullptr, false);
-  UpdateWindow(impl_->hwnd);
+ColorBuffer& Window::GetBackBuffer() {
+  return impl_->swapChain->GetBackBuffer();
 }
 
+ColorBuffer& Window::Present() { return impl_->swapChain->Present(); }
+
 void Window::SetTitle(std::string_view title) {
   SetWindowTextA(impl_->hwnd, title.data());
 }
@@ -109,45 +137,14 @@ LRESULT Window::Impl::s_WndProc(HWND hwnd, uint32_t msg, WPARAM wparam,
     case WM_PAINT: {
       PAINTSTRUCT ps;
       HDC hdc = BeginPaint(hwnd, &ps);
-      HDC memdc = CreateCompatibleDC(hdc);
-      HBITMAP bitmap = CreateCompatibleBitmap(hdc, impl->colorBuffer.GetWidth(),
-                                              impl->colorBuffer.GetHeight());
-      auto* oldBitmap = reinterpret_cast<HBITMAP>(SelectObject(memdc, bitmap));
-
-      const BITMAPINFO bmi{
-          .bmiHeader{
-              .biSize = sizeof(BITMAPINFOHEADER),
-              .biWidth = impl->colorBuffer.GetWidth(),
-              .biHeight = impl->colorBuffer.GetHeight(),
-              .biPlanes = 1,
-              .biBitCount = 32,
-              .biCompression = BI_RGB,
-              .biSizeImage{},
-              .biXPelsPerMeter{},
-              .biYPelsPerMeter{},
-              .biClrUsed{},
-              .biClrImportant{},
-          },
-          .bmiColors{},
-      };
-
-      SetDIBitsToDevice(
-          memdc, 0, 0, static_cast<DWORD>(impl->colorBuffer.GetWidth()),
-          static_cast<DWORD>(impl->colorBuffer.GetHeight()), 0, 0, 0,
-          static_cast<UINT>(impl->colorBuffer.GetHeight()),
-          impl->colorBuffer.GetData().Get(), &bmi, DIB_RGB_COLORS);
-      StretchBlt(hdc, 0, 0, impl->descriptor.width, impl->descriptor.height,
-                 memdc, 0, 0, impl->colorBuffer.GetWidth(),
-                 impl->colorBuffer.GetHeight(), SRCCOPY);
-      SelectObject(memdc, oldBitmap);
-      DeleteObject(bitmap);
-      DeleteDC(memdc);
+      impl->BlitFront(hdc);
       EndPaint(hwnd, &ps);
       break;
     }
     case WM_SIZE: {
       if (wparam == SIZE_MINIMIZED) {
       } else {
+        std::lock_guard lock{impl->frontMutex};
         impl->descriptor.width = LOWORD(lparam);
         impl->descriptor.height = HIWORD(lparam);
       }
@@ -176,6 +173,66 @@ LRESULT Window::Impl::s_WndProc(HWND hwnd, uint32_t msg, WPARAM wparam,
   return DefWindowProc(hwnd, msg, wparam, lparam);
 }
 
+// A linear buffer is already row-major, so it is blitted directly and only
+// handed back once the blit is done. Tiled buffers are copied out first and
+// blitted by ShowFront.
+void Window::Impl::CopyBuffer(ColorBuffer& buffer) {
+  if (buffer.GetLayout() == BufferLayout::Linear) {
+    buffer.Resolve();
+    HDC hdc = GetDC(hwnd);
+    {
+      std::lock_guard lock{frontMutex};
+      front.clear();
+      Blit(hdc, buffer.GetData().Get<Color>(), buffer.GetWidth(),
+           buffer.GetHeight());
+    }
+    ReleaseDC(hwnd, hdc);
+    return;
+  }
+
+  std::lock_guard lock{frontMutex};
+  front.resize(static_cast<std::size_t>(buffer.GetSize()));
+  buffer.ReadPixels(front);
+  frontWidth = buffer.GetWidth();
+  frontHeight = buffer.GetHeight();
+}
+
+void Window::Impl::ShowFront() {
+  HDC hdc = GetDC(hwnd);
+  BlitFront(hdc);
+  ReleaseDC(hwnd, hdc);
+}
+
+void Window::Impl::BlitFront(HDC hdc) {
+  std::lock_guard lock{frontMutex};
+  if (!front.empty()) {
+    Blit(hdc, front.data(), frontWidth, frontHeight);
+  }
+}
+
+void Window::Impl::Blit(HDC hdc, const Color* pixels, int32_t width,
+                        int32_t height) {
+  const BITMAPINFO bmi{
+      .bmiHeader{
+          .biSize = sizeof(BITMAPINFOHEADER),
+          .biWidth = width,
+          .biHeight = height,
+          .biPlanes = 1,
+          .biBitCount = 32,
+          .biCompression = BI_RGB,
+          .biSizeImage{},
+          .biXPelsPerMeter{},
+          .biYPelsPerMeter{},
+          .biClrUsed{},
+          .biClrImportant{},
+      },
+      .bmiColors{},
+  };
+
+  StretchDIBits(hdc, 0, 0, descriptor.width, descriptor.height, 0, 0, width,
+                height, pixels, &bmi, DIB_RGB_COLORS, SRCCOPY);
+}
+
 static KeyCode GetKeyCode(WPARAM virtualKey) {
   switch (virtualKey) {
     case VK_LBUTTON:
@@ -0,0 +1,70 @@
+#ifndef ALLOCATION_COUNTER_H_
+#define ALLOCATION_COUNTER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Replaces the global allocation functions to count allocations on every
+// thread. Only the tester may include this, and only once.
+inline std::atomic<int64_t> allocationCount{0};
+
+static void* CountedAllocate(std::size_t bytes, std::size_t alignment) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  bytes = (bytes + alignment - 1uz) & ~(alignment - 1uz);
+  void* data = std::aligned_alloc(alignment, bytes == 0 ? alignment : bytes);
+  if (data == nullptr) {
+    throw std::bad_alloc{};
+  }
+  return data;
+}
+
+void* operator new(std::size_t bytes) {
+  return CountedAllocate(bytes, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(std::size_t bytes, std::align_val_t alignment) {
+  return CountedAllocate(bytes, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t bytes, const std::nothrow_t&) noexcept {
+  try {
+    return CountedAllocate(bytes, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+
+void* operator new(std::size_t bytes, std::align_val_t alignment,
+                   const std::nothrow_t&) noexcept {
+  try {
+    return CountedAllocate(bytes, static_cast<std::size_t>(alignment));
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+
+void operator delete(void* data) noexcept { std::free(data); }
+
+void operator delete(void* data, std::size_t) noexcept { std::free(data); }
+
+void operator delete(void* data, std::align_val_t) noexcept {
+  std::free(data);
+}
+
+void operator delete(void* data, std::size_t, std::align_val_t) noexcept {
+  std::free(data);
+}
+
+void operator delete(void* data, const std::nothrow_t&) noexcept {
+  std::free(data);
+}
+
+void operator delete(void* data, std::align_val_t,
+                     const std::nothrow_t&) noexcept {
+  std::free(data);
+}
+
+#endif  // ALLOCATION_COUNTER_H_
\ No newline at end of file
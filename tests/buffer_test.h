@@ -0,0 +1,280 @@
+#ifndef BUFFER_TEST_H_
+#define BUFFER_TEST_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "render/buffer.h"
+#include "render/color.h"
+#include "render/gbuffer.h"
+#include "render/visibility_buffer.h"
+#include "unit_test.h"
+
+// Two tiles across and two down, the last ones partial.
+inline constexpr int32_t BufferTestWidth = 100;
+inline constexpr int32_t BufferTestHeight = 70;
+
+TEST(ColorBuffer, TestClearIsDeferredPerTile) {
+  constexpr softy::Color red{0xFFFF0000};
+  constexpr softy::Color blue{0xFF0000FF};
+  softy::ColorBuffer buffer{BufferTestWidth, BufferTestHeight};
+  buffer.Clear(red);
+  buffer.Resolve();
+
+  buffer.Clear(blue);
+  ASSERT_EQ(red.argb, buffer.GetPixel(0, 0).argb);
+
+  buffer.ResolveTile(0);
+  ASSERT_EQ(blue.argb, buffer.GetPixel(0, 0).argb);
+  ASSERT_EQ(blue.argb, buffer.GetPixel(63, 63).argb);
+  ASSERT_EQ(red.argb, buffer.GetPixel(64, 0).argb);
+  ASSERT_EQ(red.argb, buffer.GetPixel(0, 64).argb);
+
+  buffer.Resolve();
+  ASSERT_EQ(blue.argb, buffer.GetPixel(99, 69).argb);
+}
+
+TEST(ColorBuffer, TestResolvedTilesKeepLaterWrites) {
+  constexpr softy::Color green{0xFF00FF00};
+  constexpr softy::Color white{0xFFFFFFFF};
+  softy::ColorBuffer buffer{BufferTestWidth, BufferTestHeight};
+  buffer.Clear(green);
+  buffer.ResolveTile(3);
+  buffer.SetPixel(80, 66, white);
+  buffer.ResolveTile(3);
+  buffer.Resolve();
+  ASSERT_EQ(white.argb, buffer.GetPixel(80, 66).argb);
+  ASSERT_EQ(green.argb, buffer.GetPixel(81, 66).argb);
+}
+
+TEST(ColorBuffer, TestReadPixelsResolvesPendingClears) {
+  constexpr softy::Color gray{0xFF808080};
+  softy::ColorBuffer buffer{BufferTestWidth, BufferTestHeight};
+  buffer.Clear(gray);
+
+  std::vector<softy::Color> pixels(buffer.GetSize());
+  buffer.ReadPixels(pixels);
+  int32_t wrong = 0;
+  for (softy::Color pixel : pixels) {
+    wrong += pixel.argb != gray.argb;
+  }
+  ASSERT_EQ(0, wrong);
+}
+
+TEST(DepthBuffer, TestClearIsDeferredPerTile) {
+  softy::DepthBuffer buffer{BufferTestWidth, BufferTestHeight};
+  buffer.Clear(0.5f);
+  buffer.Resolve();
+
+  buffer.Clear(1.0f);
+  ASSERT_EQ_FLOAT(0.5f, buffer.GetDepth(99, 69));
+  buffer.ResolveTile(3);
+  ASSERT_EQ_FLOAT(1.0f, buffer.GetDepth(99, 69));
+  ASSERT_EQ_FLOAT(0.5f, buffer.GetDepth(0, 0));
+
+  std::vector<float> depths(static_cast<std::size_t>(buffer.GetSize()));
+  buffer.ReadDepths(depths);
+  int32_t wrong = 0;
+  for (float depth : depths) {
+    wrong += depth != 1.0f;
+  }
+  ASSERT_EQ(0, wrong);
+}
+
+inline softy::Color GetTestPattern(int32_t x, int32_t y) {
+  return softy::Color{0xFF000000u | static_cast<uint32_t>(y << 8 | x)};
+}
+
+TEST(ColorBuffer, TestTiledPixelIndicesAreUnique) {
+  std::set<std::size_t> indices;
+  for (int32_t y = 0; y < BufferTestHeight; ++y) {
+    for (int32_t x = 0; x < BufferTestWidth; ++x) {
+      indices.insert(softy::GetPixelIndex(softy::BufferLayout::Tiled,
+                                          BufferTestWidth, x, y));
+    }
+  }
+  ASSERT_EQ(static_cast<std::size_t>(BufferTestWidth * BufferTestHeight),
+            indices.size());
+  // Whole tiles are stored, partial ones included.
+  ASSERT_EQ(true, *indices.rbegin() < 4uz * softy::TileSize * softy::TileSize);
+}
+
+TEST(ColorBuffer, TestReadPixelsIsRowMajorInEveryLayout) {
+  for (softy::BufferLayout layout :
+       {softy::BufferLayout::Linear, softy::BufferLayout::Tiled}) {
+    softy::ColorBuffer buffer{BufferTestWidth, BufferTestHeight, layout};
+    buffer.Clear(softy::Color{});
+    buffer.Resolve();
+    for (int32_t y = 0; y < BufferTestHeight; ++y) {
+      for (int32_t x = 0; x < BufferTestWidth; ++x) {
+        buffer.SetPixel(x, y, GetTestPattern(x, y));
+      }
+    }
+
+    std::vector<softy::Color> pixels(buffer.GetSize());
+    buffer.ReadPixels(pixels);
+    int32_t wrong = 0;
+    for (int32_t y = 0; y < BufferTestHeight; ++y) {
+      for (int32_t x = 0; x < BufferTestWidth; ++x) {
+        softy::Color pixel =
+            pixels[static_cast<std::size_t>(y * BufferTestWidth + x)];
+        wrong += pixel.argb != GetTestPattern(x, y).argb;
+      }
+    }
+    ASSERT_EQ(0, wrong);
+  }
+}
+
+TEST(ColorBuffer, TestBlocksAddressTheirPixels) {
+  for (softy::BufferLayout layout :
+       {softy::BufferLayout::Linear, softy::BufferLayout::Tiled}) {
+    softy::ColorBuffer buffer{BufferTestWidth, BufferTestHeight, layout};
+    buffer.Clear(softy::Color{});
+    buffer.Resolve();
+    for (int32_t y = 0; y < BufferTestHeight; ++y) {
+      for (int32_t x = 0; x < BufferTestWidth; ++x) {
+        buffer.SetPixel(x, y, GetTestPattern(x, y));
+      }
+    }
+
+    int32_t wrong = 0;
+    softy::PixelBlock<softy::Color> block = buffer.GetBlock(72, 64);
+    for (int32_t y = 0; y < 6; ++y) {
+      for (int32_t x = 0; x < softy::BlockSize; ++x) {
+        wrong += block(x, y).argb != GetTestPattern(72 + x, 64 + y).argb;
+      }
+    }
+    ASSERT_EQ(0, wrong);
+  }
+}
+
+TEST(DepthBuffer, TestReadDepthsIsRowMajorWhenTiled) {
+  softy::DepthBuffer buffer{BufferTestWidth, BufferTestHeight,
+                            softy::BufferLayout::Tiled};
+  buffer.Clear(1.0f);
+  buffer.Resolve();
+  for (int32_t y = 0; y < BufferTestHeight; ++y) {
+    for (int32_t x = 0; x < BufferTestWidth; ++x) {
+      buffer.SetDepth(x, y, static_cast<float>(y * BufferTestWidth + x));
+    }
+  }
+
+  std::vector<float> depths(static_cast<std::size_t>(buffer.GetSize()));
+  buffer.ReadDepths(depths);
+  int32_t wrong = 0;
+  for (std::size_t i = 0; i < depths.size(); ++i) {
+    wrong += depths[i] != static_cast<float>(i);
+  }
+  ASSERT_EQ(0, wrong);
+}
+
+TEST(GBuffer, TestClearEmptiesEveryTexel) {
+  softy::GBuffer gbuffer{BufferTestWidth + 1, BufferTestHeight};
+  for (int32_t y = 0; y < BufferTestHeight; ++y) {
+    for (int32_t x = 0; x < BufferTestWidth + 1; ++x) {
+      gbuffer.SetTexel(x, y, softy::GBufferTexel{1, softy::Color{2u}});
+    }
+  }
+
+  gbuffer.Clear();
+  int32_t wrong = 0;
+  for (int32_t y = 0; y < BufferTestHeight; ++y) {
+    for (int32_t x = 0; x < BufferTestWidth + 1; ++x) {
+      softy::GBufferTexel texel = gbuffer.GetTexel(x, y);
+      wrong += texel.normal != 0 || texel.albedo.argb != 0;
+    }
+  }
+  ASSERT_EQ(0, wrong);
+}
+
+TEST(VisibilityBuffer, TestClearEmptiesEveryPixel) {
+  softy::VisibilityBuffer visibility{BufferTestWidth + 1, BufferTestHeight};
+  for (int32_t y = 0; y < BufferTestHeight; ++y) {
+    for (int32_t x = 0; x < BufferTestWidth + 1; ++x) {
+      visibility.SetId(x, y, softy::MakeVisibilityId(1, 2));
+    }
+  }
+
+  visibility.Clear();
+  int32_t wrong = 0;
+  for (int32_t y = 0; y < BufferTestHeight; ++y) {
+    for (int32_t x = 0; x < BufferTestWidth + 1; ++x) {
+      wrong += visibility.GetId(x, y) != softy::EmptyVisibility;
+    }
+  }
+  ASSERT_EQ(0, wrong);
+}
+
+TEST(Buffer, TestCapacityIsASizeClass) {
+  for (std::size_t bytes : {1uz, 64uz, 65uz, 1000uz, 4097uz, 123457uz}) {
+    softy::Buffer buffer{8, bytes};
+    ASSERT_EQ(true, buffer.GetCapacity() >= bytes);
+    ASSERT_EQ(true, buffer.GetCapacity() <= bytes + bytes / 4 + 64);
+    ASSERT_EQ(0uz, buffer.GetCapacity() % softy::CacheLineSize);
+  }
+}
+
+TEST(Buffer, TestHugeAlignmentIsHonored) {
+  softy::Buffer buffer{8, 3uz << 20, softy::HugePageSize};
+  ASSERT_EQ(0uz, reinterpret_cast<std::uintptr_t>(buffer.Get()) %
+                     softy::HugePageSize);
+  ASSERT_EQ(0uz, buffer.GetCapacity() % softy::HugePageSize);
+}
+
+TEST(Buffer, TestAllocateKeepsBlockOfSameSizeClass) {
+  softy::Buffer buffer{32, 1000};
+  const void* data = buffer.Get();
+  buffer.Allocate(32, 990);
+  ASSERT_EQ(true, buffer.Get() == data);
+}
+
+TEST(Buffer, TestCopyAndMove) {
+  softy::Buffer buffer{32, 100};
+  for (uint32_t i = 0; i < 100; ++i) {
+    buffer.Get<uint32_t>()[i] = i;
+  }
+
+  softy::Buffer copy{buffer};
+  ASSERT_EQ(true, copy.Get() != buffer.Get());
+  int32_t wrong = 0;
+  for (uint32_t i = 0; i < 100; ++i) {
+    wrong += copy.Get<uint32_t>()[i] != i;
+  }
+  ASSERT_EQ(0, wrong);
+
+  const void* data = buffer.Get();
+  softy::Buffer moved{std::move(buffer)};
+  ASSERT_EQ(true, moved.Get() == data);
+  ASSERT_EQ(true, buffer.Get() == nullptr);
+  ASSERT_EQ(0uz, buffer.GetCapacity());
+}
+
+// An odd size so that no other test leaves a block of its size class free.
+inline constexpr std::size_t PooledTestBytes = 77777;
+
+TEST(Buffer, TestReleasedBlockIsReused) {
+  const void* data = nullptr;
+  {
+    softy::Buffer buffer{8, PooledTestBytes};
+    data = buffer.Get();
+  }
+  softy::Buffer buffer{8, PooledTestBytes};
+  ASSERT_EQ(true, buffer.Get() == data);
+}
+
+TEST(Buffer, TestBlockOverBudgetIsNotPooled) {
+  const void* data = nullptr;
+  {
+    softy::Buffer buffer{8, PooledTestBytes};
+    data = buffer.Get();
+  }
+  // Releasing it would otherwise push every other free block out.
+  { softy::Buffer huge{8, softy::MaxPooledBytes + 1}; }
+  softy::Buffer buffer{8, PooledTestBytes};
+  ASSERT_EQ(true, buffer.Get() == data);
+}
+
+#endif  // BUFFER_TEST_H_
\ No newline at end of file
@@ -0,0 +1,132 @@
+#ifndef CLIPPER_TEST_H_
+#define CLIPPER_TEST_H_
+
+#include <array>
+#include <bit>
+#include <cstddef>
+
+#include "math/vector.h"
+#include "render/clipper.h"
+#include "render/vertex.h"
+#include "unit_test.h"
+
+inline softy::VertexOutput MakeClipVertex(float x, float y, float z, float w) {
+  softy::VertexOutput v{};
+  v.position = softy::v4f{x, y, z, w};
+  return v;
+}
+
+inline softy::Outcode ClipPlanes(const softy::VertexOutput& v0,
+                                 const softy::VertexOutput& v1,
+                                 const softy::VertexOutput& v2,
+                                 softy::v2f guardBand) {
+  return softy::ComputeOutcode(v0.position, guardBand) |
+         softy::ComputeOutcode(v1.position, guardBand) |
+         softy::ComputeOutcode(v2.position, guardBand);
+}
+
+inline bool InsideGuardBand(softy::v4f p, softy::v2f guardBand) {
+  constexpr float epsilon = 1e-4f;
+  float w = p[3] * (1.0f + epsilon);
+  return p[0] <= w * guardBand[0] && p[0] >= -w * guardBand[0] &&
+         p[1] <= w * guardBand[1] && p[1] >= -w * guardBand[1] &&
+         p[2] <= w && p[2] >= -w && p[3] > 0.0f;
+}
+
+TEST(Clipper, TestInsideTriangleIsUnchanged) {
+  softy::v2f guardBand{2.0f, 2.0f};
+  auto v0 = MakeClipVertex(-0.5f, -0.5f, 0.0f, 1.0f);
+  auto v1 = MakeClipVertex(0.5f, -0.5f, 0.0f, 1.0f);
+  auto v2 = MakeClipVertex(0.0f, 0.5f, 0.0f, 1.0f);
+  ASSERT_EQ(0u, ClipPlanes(v0, v1, v2, guardBand) & softy::ClipPlaneMask);
+
+  softy::ClipPolygon polygon;
+  softy::ClipTriangle(v0, v1, v2, {}, 0, guardBand, 0, polygon);
+  ASSERT_EQ(3uz, polygon.size);
+  ASSERT_EQ_FLOAT(0.5f, polygon.vertices[1].position[0]);
+}
+
+TEST(Clipper, TestOutsideTriangleIsEmpty) {
+  softy::v2f guardBand{2.0f, 2.0f};
+  auto v0 = MakeClipVertex(3.0f, 0.0f, 0.0f, 1.0f);
+  auto v1 = MakeClipVertex(4.0f, 0.0f, 0.0f, 1.0f);
+  auto v2 = MakeClipVertex(3.5f, 1.0f, 0.0f, 1.0f);
+
+  softy::ClipPolygon polygon;
+  softy::ClipTriangle(v0, v1, v2, {}, ClipPlanes(v0, v1, v2, guardBand),
+                      guardBand, 0, polygon);
+  ASSERT_EQ(true, polygon.size < 3);
+}
+
+TEST(Clipper, TestClippedVerticesLieInsideEveryPlane) {
+  softy::v2f guardBand{1.5f, 1.5f};
+  auto v0 = MakeClipVertex(-8.0f, -8.0f, -3.0f, 1.0f);
+  auto v1 = MakeClipVertex(9.0f, -7.0f, 0.5f, 1.0f);
+  auto v2 = MakeClipVertex(0.5f, 9.0f, 3.0f, 1.0f);
+  softy::Outcode planes = ClipPlanes(v0, v1, v2, guardBand);
+
+  softy::ClipPolygon polygon;
+  softy::ClipTriangle(v0, v1, v2, {}, planes, guardBand, 0, polygon);
+  ASSERT_EQ(true, polygon.size >= 3);
+  ASSERT_EQ(true, polygon.size <= polygon.vertices.size());
+  for (std::size_t i = 0; i < polygon.size; ++i) {
+    ASSERT_EQ(true, InsideGuardBand(polygon.vertices[i].position, guardBand));
+  }
+}
+
+TEST(Clipper, TestNearPlaneClipsBehindCamera) {
+  softy::v2f guardBand{2.0f, 2.0f};
+  auto v0 = MakeClipVertex(0.0f, 0.0f, 0.5f, 1.0f);
+  auto v1 = MakeClipVertex(0.5f, 0.0f, 0.5f, 1.0f);
+  auto v2 = MakeClipVertex(0.0f, 0.5f, 2.0f, -1.0f);
+
+  softy::ClipPolygon polygon;
+  softy::ClipTriangle(v0, v1, v2, {}, ClipPlanes(v0, v1, v2, guardBand),
+                      guardBand, 0, polygon);
+  ASSERT_EQ(true, polygon.size >= 3);
+  for (std::size_t i = 0; i < polygon.size; ++i) {
+    ASSERT_EQ(true, InsideGuardBand(polygon.vertices[i].position, guardBand));
+  }
+}
+
+TEST(Clipper, TestUserVaryingsFollowClippedVertices) {
+  softy::v2f guardBand{1.0f, 1.0f};
+  auto v0 = MakeClipVertex(-0.5f, -0.5f, 0.0f, 1.0f);
+  auto v1 = MakeClipVertex(3.0f, 0.0f, 0.0f, 1.0f);
+  auto v2 = MakeClipVertex(-0.5f, 0.5f, 0.0f, 1.0f);
+  std::array<softy::UserVaryings, 3> user{};
+  user[0][1][0] = v0.position[0];
+  user[1][1][0] = v1.position[0];
+  user[2][1][0] = v2.position[0];
+
+  softy::ClipPolygon polygon;
+  softy::ClipTriangle(v0, v1, v2, {&user[0], &user[1], &user[2]},
+                      ClipPlanes(v0, v1, v2, guardBand), guardBand,
+                      softy::varyings::User1, polygon);
+  ASSERT_EQ(4uz, polygon.size);
+  for (std::size_t i = 0; i < polygon.size; ++i) {
+    ASSERT_EQ_FLOAT(polygon.vertices[i].position[0],
+                    polygon.user[i][1][0]);
+  }
+}
+
+// A sliver whose vertices differ by up to 2^100 in scale. Round-off in its
+// plane distances makes the clipped polygon non-convex, so it gains more
+// vertices than any triangle can.
+TEST(Clipper, TestOverflowingPolygonIsDropped) {
+  softy::v2f guardBand{3.0f, 3.0f};
+  auto v0 = MakeClipVertex(0x1.fd70dep+79f, -0x1.ff02fap+80f,
+                           -0x1.72c428p+118f, 0x1.49d0b6p+75f);
+  auto v1 = MakeClipVertex(-0x1.852dacp+18f, -0x1.cf6678p+37f,
+                           -0x1.d0b792p+54f, -0x1.91a9ccp-28f);
+  auto v2 = MakeClipVertex(0x1.296aeap-16f, -0x1.6ffcdep+61f,
+                           0x1.a6129p+86f, 0x1.21c7c6p+82f);
+  softy::Outcode planes = ClipPlanes(v0, v1, v2, guardBand);
+  ASSERT_EQ(true, std::popcount(planes & softy::ClipPlaneMask) > 3);
+
+  softy::ClipPolygon polygon;
+  softy::ClipTriangle(v0, v1, v2, {}, planes, guardBand, 0, polygon);
+  ASSERT_EQ(0uz, polygon.size);
+}
+
+#endif  // CLIPPER_TEST_H_
\ No newline at end of file
@@ -0,0 +1,68 @@
+#ifndef FRAME_ARENA_TEST_H_
+#define FRAME_ARENA_TEST_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "core/frame_arena.h"
+#include "unit_test.h"
+
+TEST(FrameArena, TestAllocationsAreAlignedAndDisjoint) {
+  softy::FrameArena arena;
+  auto* a = static_cast<std::byte*>(arena.Allocate(3, 1));
+  auto* b = static_cast<std::byte*>(arena.Allocate(16, 16));
+  auto* c = static_cast<std::byte*>(arena.Allocate(1, 64));
+  ASSERT_EQ(0uz, reinterpret_cast<std::uintptr_t>(b) % 16);
+  ASSERT_EQ(0uz, reinterpret_cast<std::uintptr_t>(c) % 64);
+  ASSERT_EQ(true, a + 3 <= b);
+  ASSERT_EQ(true, b + 16 <= c);
+}
+
+TEST(FrameArena, TestResetReusesMemory) {
+  softy::FrameArena arena;
+  void* first = arena.Allocate(100, 8);
+  arena.Allocate(200, 8);
+  arena.Reset();
+  ASSERT_EQ(true, arena.Allocate(100, 8) == first);
+}
+
+TEST(FrameArena, TestResetGrowsToFitTheFrame) {
+  softy::FrameArena arena;
+  constexpr std::size_t bytes = 600uz << 10;
+  for (int32_t i = 0; i < 8; ++i) {
+    arena.Allocate(bytes, 8);
+  }
+  std::size_t capacity = arena.GetCapacity();
+  ASSERT_EQ(true, capacity >= 8 * bytes);
+
+  // The next frame of the same size fits into what the arena has.
+  arena.Reset();
+  ASSERT_EQ(capacity, arena.GetCapacity());
+  for (int32_t i = 0; i < 8; ++i) {
+    arena.Allocate(bytes, 8);
+  }
+  ASSERT_EQ(capacity, arena.GetCapacity());
+}
+
+TEST(FrameArena, TestResetAllResetsThreadArenas) {
+  softy::FrameArena& arena = softy::FrameArena::ForThread();
+  softy::FrameArena::ResetAll();
+  void* first = arena.Allocate(64, 8);
+  arena.Allocate(64, 8);
+  softy::FrameArena::ResetAll();
+  ASSERT_EQ(true, arena.Allocate(64, 8) == first);
+  softy::FrameArena::ResetAll();
+}
+
+TEST(FrameVector, TestAllocatesFromTheThreadArena) {
+  softy::FrameArena::ResetAll();
+  softy::FrameVector<int32_t> values;
+  for (int32_t i = 0; i < 1000; ++i) {
+    values.push_back(i);
+  }
+  ASSERT_EQ(true, values.get_allocator().GetArena() ==
+                      &softy::FrameArena::ForThread());
+  ASSERT_EQ(999, values.back());
+}
+
+#endif  // FRAME_ARENA_TEST_H_
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef PIPELINE_STATE_TEST_H_
+#define PIPELINE_STATE_TEST_H_
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include "render/pipeline_state.h"
+#include "render/render_state.h"
+#include "shader/shader.h"
+#include "unit_test.h"
+
+TEST(PipelineState, TestCopiedShadersGetNewIds) {
+  softy::Shader shader = softy::UnlitColorShader();
+  softy::Shader copy = shader;
+  uint64_t copyId = copy.GetId();
+  softy::Shader moved = std::move(copy);
+  ASSERT_EQ(false, shader.GetId() == copyId);
+  ASSERT_EQ(false, copyId == moved.GetId());
+}
+
+TEST(PipelineState, TestCacheSharesEqualDescs) {
+  softy::Shader shader = softy::UnlitColorShader();
+  softy::PipelineStateDesc desc{
+      .shader = &shader,
+      .depthState = {},
+      .cullMode = softy::CullMode::Back,
+      .blendMode = softy::BlendMode::Opaque,
+  };
+  softy::PipelineStateCache& cache = softy::PipelineStateCache::Instance();
+  const softy::PipelineState* state = cache.Get(desc);
+  ASSERT_EQ(true, state == cache.Get(desc));
+
+  desc.cullMode = softy::CullMode::None;
+  ASSERT_EQ(false, state == cache.Get(desc));
+}
+
+TEST(PipelineState, TestCacheIgnoresReusedShaderAddresses) {
+  std::optional<softy::Shader> shader{softy::UnlitColorShader()};
+  softy::PipelineStateDesc desc{
+      .shader = &*shader,
+      .depthState = {},
+      .cullMode = softy::CullMode::Back,
+      .blendMode = softy::BlendMode::Opaque,
+  };
+  softy::PipelineStateCache& cache = softy::PipelineStateCache::Instance();
+  const softy::PipelineState* first = cache.Get(desc);
+
+  shader.emplace(softy::UvColorShader());
+  const softy::PipelineState* second = cache.Get(desc);
+  ASSERT_EQ(false, first == second);
+  ASSERT_EQ(shader->GetId(), second->GetDesc().shader->GetId());
+}
+
+#endif  // PIPELINE_STATE_TEST_H_
\ No newline at end of file
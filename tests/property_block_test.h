@@ -0,0 +1,53 @@
+#ifndef PROPERTY_BLOCK_TEST_H_
+#define PROPERTY_BLOCK_TEST_H_
+
+#include <cstdint>
+#include <optional>
+
+#include "render/color.h"
+#include "render/property_block.h"
+#include "unit_test.h"
+
+TEST(PropertyBlock, TestSlotsAreAligned) {
+  softy::PropertyLayout layout;
+  softy::PropertySlot<uint8_t> flag = layout.Add<uint8_t>("Flag_");
+  softy::PropertySlot<float> scale = layout.Add<float>("Scale_");
+  softy::PropertySlot<double> bias = layout.Add<double>("Bias_");
+  ASSERT_EQ(0u, flag.offset);
+  ASSERT_EQ(4u, scale.offset);
+  ASSERT_EQ(8u, bias.offset);
+  ASSERT_EQ(16uz, layout.GetSize());
+}
+
+TEST(PropertyBlock, TestSetAndGet) {
+  softy::PropertyLayout layout;
+  softy::PropertySlot<float> scale = layout.Add<float>("Scale_");
+  softy::PropertySlot<softy::Color> color = layout.Add<softy::Color>("Color_");
+  softy::PropertyBlock block{layout};
+
+  block.Set(scale, 2.5f);
+  block.Set(color, softy::Color{0xFF336699});
+  ASSERT_EQ_FLOAT(2.5f, block.Get(scale));
+  ASSERT_EQ(0xFF336699u, block.Get(color).argb);
+}
+
+TEST(PropertyBlock, TestFindByName) {
+  softy::PropertyLayout layout;
+  layout.Add<float>("Scale_");
+  softy::PropertySlot<int32_t> count = layout.Add<int32_t>("Count_");
+
+  std::optional<softy::PropertySlot<int32_t>> found =
+      layout.Find<int32_t>("Count_");
+  ASSERT_EQ(true, found.has_value());
+  ASSERT_EQ(count.offset, found->offset);
+  ASSERT_EQ(false, layout.Find<int32_t>("Missing_").has_value());
+}
+
+TEST(PropertyBlock, TestFindRejectsTypeMismatch) {
+  softy::PropertyLayout layout;
+  layout.Add<float>("Scale_");
+  ASSERT_EQ(false, layout.Find<int32_t>("Scale_").has_value());
+  ASSERT_EQ(false, layout.Find<double>("Scale_").has_value());
+}
+
+#endif  // PROPERTY_BLOCK_TEST_H_
\ No newline at end of file
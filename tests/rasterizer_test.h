@@ -0,0 +1,145 @@
+#ifndef RASTERIZER_TEST_H_
+#define RASTERIZER_TEST_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "core/frame_arena.h"
+#include "render/buffer.h"
+#include "render/color.h"
+#include "render/coverage.h"
+#include "render/rasterizer.h"
+#include "render/render_state.h"
+#include "render/vertex.h"
+#include "shader/fragment.h"
+#include "unit_test.h"
+
+TEST(Coverage, TestKernelsMatchScalar) {
+  std::mt19937 rng{1};
+  std::uniform_int_distribution<int32_t> origin{-2000, 2000};
+  std::uniform_int_distribution<int32_t> step{-300, 300};
+  softy::CoverageKernel kernel = softy::GetCoverageKernel();
+  for (int32_t i = 0; i < 10000; ++i) {
+    softy::BlockEdges edges{};
+    for (std::size_t e = 0; e < 3; ++e) {
+      edges.origin[e] = origin(rng);
+      edges.stepX[e] = step(rng);
+      edges.stepY[e] = step(rng);
+    }
+    uint64_t expected = softy::CoverageScalar(edges);
+    ASSERT_EQ(expected, kernel(edges));
+    ASSERT_EQ(expected, softy::CoverageSse2(edges));
+  }
+}
+
+// Counts how often every pixel of a width x height target is shaded when a
+// jittered grid of quads spanning extent in NDC is drawn.
+inline std::vector<int32_t> DrawJitteredGrid(int32_t width, int32_t height,
+                                             float extent) {
+  constexpr int32_t n = 23;
+  std::mt19937 rng{7};
+  std::uniform_real_distribution<float> jitter{-0.3f, 0.3f};
+  std::vector<softy::VertexOutput> vertices;
+  for (int32_t y = 0; y <= n; ++y) {
+    for (int32_t x = 0; x <= n; ++x) {
+      bool border = x == 0 || x == n || y == 0 || y == n;
+      float fx = static_cast<float>(x) + (border ? 0.0f : jitter(rng));
+      float fy = static_cast<float>(y) + (border ? 0.0f : jitter(rng));
+      softy::VertexOutput v{};
+      v.position = softy::v4f{-extent + 2.0f * extent * fx / n,
+                              -extent + 2.0f * extent * fy / n, 0.0f, 1.0f};
+      vertices.push_back(v);
+    }
+  }
+
+  std::vector<int> indices;
+  for (int32_t y = 0; y < n; ++y) {
+    for (int32_t x = 0; x < n; ++x) {
+      int a = y * (n + 1) + x;
+      int c = a + n + 1;
+      indices.insert(indices.end(), {a, a + 1, c + 1, a, c + 1, c});
+    }
+  }
+
+  std::vector<int32_t> hits(static_cast<std::size_t>(width * height));
+  softy::ConstantBuffer cb{};
+  softy::ColorBuffer rt{width, height};
+  softy::FragmentShader fs = [&](const softy::ConstantBuffer&,
+                                 const softy::Fragment& f) {
+    auto x = static_cast<int32_t>(f.v.position[0]);
+    auto y = static_cast<int32_t>(f.v.position[1]);
+    ++hits[static_cast<std::size_t>(y * width + x)];
+    return softy::Color{0xFFFFFFFF};
+  };
+  softy::Rasterize<softy::RasterState{}>(cb, rt, nullptr,
+                                         softy::CullMode::Back, vertices,
+                                         {}, indices, fs);
+  softy::FrameArena::ResetAll();
+  return hits;
+}
+
+TEST(Rasterizer, TestSharedEdgesAreWatertight) {
+  constexpr int32_t width = 320;
+  constexpr int32_t height = 240;
+  for (float extent : {0.9f, 1.7f}) {
+    std::vector<int32_t> hits = DrawJitteredGrid(width, height, extent);
+    float x0 = (1.0f - extent) * width / 2.0f;
+    float x1 = (1.0f + extent) * width / 2.0f;
+    float y0 = (1.0f - extent) * height / 2.0f;
+    float y1 = (1.0f + extent) * height / 2.0f;
+
+    int32_t holes = 0;
+    int32_t overlaps = 0;
+    for (int32_t y = 0; y < height; ++y) {
+      for (int32_t x = 0; x < width; ++x) {
+        float cx = static_cast<float>(x) + 0.5f;
+        float cy = static_cast<float>(y) + 0.5f;
+        bool inside = cx > x0 + 0.01f && cx < x1 - 0.01f &&
+                      cy > y0 + 0.01f && cy < y1 - 0.01f;
+        int32_t count = hits[static_cast<std::size_t>(y * width + x)];
+        overlaps += count > 1;
+        holes += inside && count == 0;
+      }
+    }
+    ASSERT_EQ(0, holes);
+    ASSERT_EQ(0, overlaps);
+  }
+}
+
+TEST(Rasterizer, TestUserVaryingsAreInterpolated) {
+  constexpr int32_t width = 64;
+  constexpr int32_t height = 64;
+  std::vector<softy::VertexOutput> vertices(3);
+  vertices[0].position = softy::v4f{-1.0f, -1.0f, 0.0f, 1.0f};
+  vertices[1].position = softy::v4f{3.0f, -1.0f, 0.0f, 1.0f};
+  vertices[2].position = softy::v4f{-1.0f, 3.0f, 0.0f, 1.0f};
+  // user[1].x follows the pixel's x coordinate.
+  std::vector<softy::UserVaryings> user(3);
+  user[0][1][0] = 0.0f;
+  user[1][1][0] = 2.0f * width;
+  user[2][1][0] = 0.0f;
+  std::vector<int> indices{0, 1, 2};
+
+  std::atomic<int32_t> shaded = 0;
+  std::atomic<int32_t> mismatches = 0;
+  auto fs = softy::DeclareVaryings<softy::varyings::User1>(
+      [&](const softy::ConstantBuffer&, const softy::Fragment& f) {
+        float error = f.user[1][0] - f.v.position[0];
+        ++shaded;
+        mismatches += error < -0.01f || error > 0.01f;
+        return softy::Color{0xFFFFFFFF};
+      });
+  softy::ConstantBuffer cb{};
+  softy::ColorBuffer rt{width, height};
+  softy::Rasterize<softy::RasterState{}>(cb, rt, nullptr,
+                                         softy::CullMode::None, vertices,
+                                         user, indices, fs);
+  softy::FrameArena::ResetAll();
+  ASSERT_EQ(width * height, shaded.load());
+  ASSERT_EQ(0, mismatches.load());
+}
+
+#endif  // RASTERIZER_TEST_H_
\ No newline at end of file
@@ -0,0 +1,145 @@
+#ifndef RENDER_PIPELINE_TEST_H_
+#define RENDER_PIPELINE_TEST_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "core/transform.h"
+#include "geometry/generator.h"
+#include "math/matrix.h"
+#include "math/vector.h"
+#include "render/buffer.h"
+#include "render/clipper.h"
+#include "render/camera.h"
+#include "render/color.h"
+#include "render/forward_render_pipeline.h"
+#include "render/material.h"
+#include "render/mesh.h"
+#include "render/render_pipeline.h"
+#include "render/visibility_buffer.h"
+#include "render/visibility_render_pipeline.h"
+#include "shader/shader.h"
+#include "unit_test.h"
+
+// A cube in front of the camera, drawn after hiddenDraws draws outside the
+// view of a mesh of hiddenCubes cubes.
+class PipelineTestScene {
+ public:
+  static constexpr int32_t Width = 96;
+  static constexpr int32_t Height = 64;
+
+  PipelineTestScene(softy::RenderPipeline& pipeline, std::size_t hiddenDraws,
+                    std::size_t hiddenCubes = 1)
+      : pipeline_{pipeline}, hiddenDraws_{hiddenDraws} {
+    camera_.GetTransform().position = softy::v3f{0.0f, 0.0f, 2.5f};
+    material_.SetProperty("Color_", softy::Color{0xFFFFFFFF});
+    cube_->SetMaterial(&material_);
+
+    const std::vector<int32_t>& cubeIndices = cube_->GetIndices();
+    std::vector<int32_t> indices;
+    indices.reserve(cubeIndices.size() * hiddenCubes);
+    for (std::size_t i = 0; i < hiddenCubes; ++i) {
+      indices.insert(indices.end(), cubeIndices.begin(), cubeIndices.end());
+    }
+    hidden_ = std::make_unique<softy::Mesh>(cube_->GetVertices(), indices,
+                                            &material_);
+    cb_.SetData(softy::ConstantBufferData{
+        .matWorld = softy::mat4::Identity(),
+        .matView = camera_.GetViewMatrix(),
+        .matProjection = camera_.GetProjectionMatrix(),
+        .properties = nullptr,
+    });
+    pipeline_.SetConstantBuffer(&cb_);
+  }
+
+  void Render() {
+    rt_.Clear(softy::Color::Black());
+    db_.Clear(1.0f);
+    softy::mat4 hidden =
+        softy::Transform::GetTranslateMatrix(softy::v3f{100.0f, 0.0f, 0.0f});
+    for (std::size_t i = 0; i < hiddenDraws_; ++i) {
+      pipeline_.AddObject(hidden_.get(), hidden);
+    }
+    pipeline_.AddObject(cube_.get(), softy::mat4::Identity());
+    pipeline_.Render(&camera_);
+  }
+
+  std::vector<softy::Color> ReadPixels() {
+    std::vector<softy::Color> pixels(rt_.GetSize());
+    rt_.ReadPixels(pixels);
+    return pixels;
+  }
+
+ private:
+  softy::RenderPipeline& pipeline_;
+  std::size_t hiddenDraws_;
+  softy::ColorBuffer rt_{Width, Height};
+  softy::DepthBuffer db_{Width, Height};
+  softy::Camera camera_{&rt_, &db_};
+  softy::Shader shader_ = softy::VertexColorShader();
+  softy::Material material_{&shader_};
+  std::unique_ptr<softy::Mesh> cube_ = softy::CreateCube();
+  std::unique_ptr<softy::Mesh> hidden_;
+  softy::ConstantBuffer cb_;
+};
+
+inline std::vector<softy::Color> RenderAfterHiddenDraws(
+    std::size_t hiddenDraws) {
+  softy::VisibilityRenderPipeline pipeline;
+  PipelineTestScene scene{pipeline, hiddenDraws};
+  scene.Render();
+  return scene.ReadPixels();
+}
+
+// Allocations of a frame after a few to warm up.
+inline int64_t CountSteadyFrameAllocations(softy::RenderPipeline& pipeline,
+                                           std::size_t hiddenDraws,
+                                           std::size_t hiddenCubes = 1) {
+  PipelineTestScene scene{pipeline, hiddenDraws, hiddenCubes};
+  for (int32_t i = 0; i < 3; ++i) {
+    scene.Render();
+  }
+  int64_t before = allocationCount.load();
+  scene.Render();
+  return allocationCount.load() - before;
+}
+
+TEST(VisibilityRenderPipeline, TestDrawsBeyondIdLimitAreShaded) {
+  std::vector<softy::Color> expected = RenderAfterHiddenDraws(0);
+  std::vector<softy::Color> actual =
+      RenderAfterHiddenDraws(softy::MaxVisibilityDraws + 5);
+
+  int32_t lit = 0;
+  int32_t mismatches = 0;
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    lit += expected[i].argb != softy::Color::Black().argb;
+    mismatches += expected[i].argb != actual[i].argb;
+  }
+  ASSERT_EQ(true, lit > 0);
+  ASSERT_EQ(0, mismatches);
+}
+
+TEST(VisibilityRenderPipeline, TestSteadyFramesDoNotAllocate) {
+  softy::VisibilityRenderPipeline pipeline;
+  ASSERT_EQ(0, CountSteadyFrameAllocations(pipeline,
+                                           softy::MaxVisibilityDraws + 5));
+}
+
+TEST(VisibilityRenderPipeline, TestSplitMeshFramesDoNotAllocate) {
+  // Enough cubes that the visibility ids of one draw cannot hold them all.
+  constexpr std::size_t cubes = softy::MaxVisibilityTriangles /
+                                    softy::MaxClippedTriangles / 12 +
+                                1;
+  softy::VisibilityRenderPipeline pipeline;
+  ASSERT_EQ(0, CountSteadyFrameAllocations(pipeline, 1, cubes));
+}
+
+TEST(ForwardRenderPipeline, TestSteadyFramesDoNotAllocate) {
+  softy::ForwardRenderPipeline pipeline;
+  ASSERT_EQ(0, CountSteadyFrameAllocations(pipeline, 40));
+}
+
+#endif  // RENDER_PIPELINE_TEST_H_
\ No newline at end of file
@@ -0,0 +1,118 @@
+#ifndef SAMPLER_TEST_H_
+#define SAMPLER_TEST_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "math/vector.h"
+#include "render/color.h"
+#include "render/sampler.h"
+#include "render/texture.h"
+#include "shader/fragment.h"
+#include "unit_test.h"
+
+inline softy::Texture2D MakeSamplerTestTexture() {
+  constexpr int32_t size = 8;
+  std::vector<softy::Color> texels;
+  for (int32_t y = 0; y < size; ++y) {
+    for (int32_t x = 0; x < size; ++x) {
+      texels.push_back(softy::Color{static_cast<uint8_t>(x * 32),
+                                    static_cast<uint8_t>(y * 32),
+                                    static_cast<uint8_t>(x * y * 4)});
+    }
+  }
+  return softy::Texture2D{size, size, texels};
+}
+
+inline std::array<softy::Lanes, 2> MakeUv(float u, float v) {
+  std::array<softy::Lanes, 2> uv{};
+  for (std::size_t lane = 0; lane < softy::PacketSize; ++lane) {
+    uv[0][lane] = u;
+    uv[1][lane] = v;
+  }
+  return uv;
+}
+
+inline constexpr std::array<softy::AddressMode, 3> SamplerTestModes{
+    softy::AddressMode::Wrap, softy::AddressMode::Clamp,
+    softy::AddressMode::Mirror};
+
+inline constexpr std::array<softy::FilterMode, 3> SamplerTestFilters{
+    softy::FilterMode::Point, softy::FilterMode::Bilinear,
+    softy::FilterMode::Trilinear};
+
+TEST(Sampler, TestKernelsMatchScalar) {
+  softy::Texture2D texture = MakeSamplerTestTexture();
+  softy::SampleKernel kernel = softy::GetSampleKernel();
+  std::array<softy::Lanes, 2> uv{};
+  uv[0] = softy::Lanes{-1.3f, 0.2f, 0.77f, 2.6f};
+  uv[1] = softy::Lanes{0.1f, -0.45f, 1.9f, 0.5f};
+  for (softy::AddressMode mode : SamplerTestModes) {
+    for (softy::FilterMode filter : SamplerTestFilters) {
+      softy::Sampler sampler{.filter = filter,
+                             .addressU = mode,
+                             .addressV = mode};
+      for (int32_t level = 0; level < texture.GetLevelCount(); ++level) {
+        softy::TexelPacket expected{};
+        softy::TexelPacket actual{};
+        softy::SampleScalar(texture, level, sampler, uv, expected);
+        kernel(texture, level, sampler, uv, actual);
+        for (std::size_t c = 0; c < expected.size(); ++c) {
+          for (std::size_t lane = 0; lane < softy::PacketSize; ++lane) {
+            ASSERT_EQ_FLOAT(expected[c][lane], actual[c][lane]);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(Sampler, TestNonFiniteUvsSampleTheOrigin) {
+  constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+  constexpr float inf = std::numeric_limits<float>::infinity();
+  softy::Texture2D texture = MakeSamplerTestTexture();
+  softy::SampleKernel kernel = softy::GetSampleKernel();
+  softy::v2f ddx{1.0f / 8.0f, 0.0f};
+  softy::v2f ddy{0.0f, 1.0f / 8.0f};
+
+  for (softy::AddressMode mode : SamplerTestModes) {
+    for (softy::FilterMode filter : SamplerTestFilters) {
+      softy::Sampler sampler{.filter = filter,
+                             .addressU = mode,
+                             .addressV = mode};
+      softy::TexelPacket expected =
+          softy::Sample(texture, sampler, MakeUv(0.0f, 0.0f), ddx, ddy);
+      for (float bad : {nan, inf, -inf}) {
+        std::array<softy::Lanes, 2> uv = MakeUv(bad, bad);
+        softy::TexelPacket scalar{};
+        softy::TexelPacket fast{};
+        softy::SampleScalar(texture, 0, sampler, uv, scalar);
+        kernel(texture, 0, sampler, uv, fast);
+        softy::TexelPacket filtered =
+            softy::Sample(texture, sampler, uv, ddx, ddy);
+        for (std::size_t c = 0; c < expected.size(); ++c) {
+          ASSERT_EQ_FLOAT(expected[c][0], scalar[c][0]);
+          ASSERT_EQ_FLOAT(expected[c][0], fast[c][0]);
+          ASSERT_EQ_FLOAT(expected[c][0], filtered[c][0]);
+        }
+      }
+    }
+  }
+}
+
+TEST(Sampler, TestNonFiniteDerivativesStayInMipChain) {
+  constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+  constexpr float inf = std::numeric_limits<float>::infinity();
+  softy::Texture2D texture = MakeSamplerTestTexture();
+  float top = static_cast<float>(texture.GetLevelCount() - 1);
+  for (float bad : {nan, inf}) {
+    float lod = softy::GetMipLevel(texture, softy::v2f{bad, bad},
+                                   softy::v2f{bad, bad});
+    ASSERT_EQ(true, lod >= 0.0f && lod <= top);
+  }
+}
+
+#endif  // SAMPLER_TEST_H_
\ No newline at end of file
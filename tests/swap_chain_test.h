@@ -0,0 +1,95 @@
+#ifndef SWAP_CHAIN_TEST_H_
+#define SWAP_CHAIN_TEST_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "render/buffer.h"
+#include "render/color.h"
+#include "unit_test.h"
+#include "window/swap_chain.h"
+
+inline constexpr int32_t SwapChainTestFrames = 20;
+
+// Presents frames filled with their number through a present thread slower
+// than the renderer, and checks that every frame shows up once, in order
+// and with its own contents.
+inline void PresentNumberedFrames(std::size_t bufferCount) {
+  constexpr int32_t width = 64;
+  constexpr int32_t height = 48;
+  std::vector<softy::Color> pixels(static_cast<std::size_t>(width * height));
+  uint32_t expected = 1;
+  int32_t outOfOrder = 0;
+  int32_t wrongPixels = 0;
+  {
+    softy::SwapChain swapChain{
+        width, height, bufferCount, softy::BufferLayout::Tiled,
+        [&](softy::ColorBuffer& buffer) {
+          buffer.ReadPixels(pixels);
+          outOfOrder += pixels[0].argb != expected;
+          for (softy::Color pixel : pixels) {
+            wrongPixels += pixel.argb != pixels[0].argb;
+          }
+          expected = pixels[0].argb + 1;
+        },
+        []() { std::this_thread::sleep_for(std::chrono::milliseconds(2)); }};
+
+    softy::ColorBuffer* back = &swapChain.GetBackBuffer();
+    for (int32_t frame = 1; frame <= SwapChainTestFrames; ++frame) {
+      back->Clear(softy::Color{static_cast<uint32_t>(frame)});
+      softy::ColorBuffer* next = &swapChain.Present();
+      ASSERT_EQ(true, next != back);
+      back = next;
+    }
+  }
+
+  ASSERT_EQ(static_cast<uint32_t>(SwapChainTestFrames + 1), expected);
+  ASSERT_EQ(0, outOfOrder);
+  ASSERT_EQ(0, wrongPixels);
+}
+
+TEST(SwapChain, TestDoubleBufferedFramesArePresentedInOrder) {
+  PresentNumberedFrames(2);
+}
+
+TEST(SwapChain, TestTripleBufferedFramesArePresentedInOrder) {
+  PresentNumberedFrames(3);
+}
+
+// The renderer must get a buffer back once it is copied, before it is shown.
+TEST(SwapChain, TestBufferIsReleasedBeforeItIsShown) {
+  std::atomic<int32_t> presented{0};
+  int32_t shown = 0;
+  bool releasedBeforeShown = false;
+  {
+    softy::SwapChain swapChain{
+        64, 48, 2, softy::BufferLayout::Linear, [](softy::ColorBuffer&) {},
+        [&]() {
+          if (shown++ > 0) {
+            return;
+          }
+          // The second frame can only be handed over once the first one's
+          // buffer is back.
+          auto deadline =
+              std::chrono::steady_clock::now() + std::chrono::seconds(1);
+          while (presented.load() < 2 &&
+                 std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+          }
+          releasedBeforeShown = presented.load() == 2;
+        }};
+    swapChain.Present();
+    ++presented;
+    swapChain.Present();
+    ++presented;
+  }
+
+  ASSERT_EQ(2, shown);
+  ASSERT_EQ(true, releasedBeforeShown);
+}
+
+#endif  // SWAP_CHAIN_TEST_H_
\ No newline at end of file
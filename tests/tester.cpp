@@ -1,9 +1,18 @@
+#include "buffer_test.h"
+#include "clipper_test.h"
+#include "frame_arena_test.h"
 #include "matrix_test.h"
+#include "pipeline_state_test.h"
+#include "property_block_test.h"
 #include "property_test.h"
+#include "rasterizer_test.h"
+#include "render_pipeline_test.h"
+#include "sampler_test.h"
+#include "swap_chain_test.h"
+#include "texture_test.h"
 #include "unit_test.h"
 #include "vector_test.h"
 
 int32_t main([[maybe_unused]] int32_t argc, [[maybe_unused]] char** argv) {
-  run_all_tests();
-  return 0;
+  return run_all_tests() == 0 ? 0 : 1;
 }
\ No newline at end of file
@@ -0,0 +1,99 @@
+#ifndef TEXTURE_TEST_H_
+#define TEXTURE_TEST_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#include "render/color.h"
+#include "render/texture.h"
+#include "unit_test.h"
+
+TEST(Texture, TestEmptyTextureHasNoSize) {
+  softy::Texture2D texture;
+  ASSERT_EQ(0, texture.GetWidth());
+  ASSERT_EQ(0, texture.GetHeight());
+  ASSERT_EQ(0, texture.GetLevelCount());
+}
+
+TEST(Texture, TestTileTexelIndexIsMorton) {
+  ASSERT_EQ(0u, softy::GetTileTexelIndex(0, 0));
+  ASSERT_EQ(1u, softy::GetTileTexelIndex(1, 0));
+  ASSERT_EQ(2u, softy::GetTileTexelIndex(0, 1));
+  ASSERT_EQ(3u, softy::GetTileTexelIndex(1, 1));
+  ASSERT_EQ(4u, softy::GetTileTexelIndex(2, 0));
+  ASSERT_EQ(15u, softy::GetTileTexelIndex(3, 3));
+
+  std::set<uint32_t> indices;
+  for (uint32_t y = 0; y < softy::TextureTileSize; ++y) {
+    for (uint32_t x = 0; x < softy::TextureTileSize; ++x) {
+      indices.insert(softy::GetTileTexelIndex(x, y));
+    }
+  }
+  ASSERT_EQ(static_cast<std::size_t>(softy::TextureTileTexels),
+            indices.size());
+}
+
+TEST(Texture, TestTexelsRoundTrip) {
+  constexpr int32_t width = 7;
+  constexpr int32_t height = 5;
+  std::vector<softy::Color> texels;
+  for (int32_t i = 0; i < width * height; ++i) {
+    texels.push_back(softy::Color{static_cast<uint32_t>(i) * 0x010203u});
+  }
+
+  softy::Texture2D texture{width, height, texels};
+  ASSERT_EQ(width, texture.GetWidth());
+  ASSERT_EQ(height, texture.GetHeight());
+  for (int32_t y = 0; y < height; ++y) {
+    for (int32_t x = 0; x < width; ++x) {
+      ASSERT_EQ(texels[static_cast<std::size_t>(y * width + x)].argb,
+                texture.GetTexel(0, x, y).argb);
+    }
+  }
+}
+
+TEST(Texture, TestMipChainLevelsDoNotOverlap) {
+  std::vector<softy::Color> texels(13 * 6);
+  softy::Texture2D texture{13, 6, texels};
+  ASSERT_EQ(4, texture.GetLevelCount());
+  ASSERT_EQ(6, texture.GetLevel(1).width);
+  ASSERT_EQ(3, texture.GetLevel(1).height);
+  ASSERT_EQ(1, texture.GetLevel(3).width);
+  ASSERT_EQ(1, texture.GetLevel(3).height);
+
+  std::set<std::size_t> indices;
+  std::size_t texelCount = 0;
+  for (int32_t i = 0; i < texture.GetLevelCount(); ++i) {
+    const softy::TextureLevel& level = texture.GetLevel(i);
+    ASSERT_EQ(0uz, level.offset % softy::TextureTileTexels);
+    for (int32_t y = 0; y < level.height; ++y) {
+      for (int32_t x = 0; x < level.width; ++x) {
+        indices.insert(level.GetTexelIndex(x, y));
+        ++texelCount;
+      }
+    }
+  }
+  ASSERT_EQ(texelCount, indices.size());
+}
+
+TEST(Texture, TestMipsAverageTheirFootprint) {
+  constexpr int32_t size = 4;
+  std::vector<softy::Color> texels;
+  for (int32_t y = 0; y < size; ++y) {
+    for (int32_t x = 0; x < size; ++x) {
+      texels.push_back(softy::Color{(x + y) % 2 == 0 ? 0xFFFFFFFFu : 0u});
+    }
+  }
+
+  softy::Texture2D texture{size, size, texels};
+  ASSERT_EQ(3, texture.GetLevelCount());
+  for (int32_t level = 1; level < texture.GetLevelCount(); ++level) {
+    softy::Color texel = texture.GetTexel(level, 0, 0);
+    ASSERT_EQ(128, static_cast<int32_t>(texel.r));
+    ASSERT_EQ(128, static_cast<int32_t>(texel.a));
+  }
+}
+
+#endif  // TEXTURE_TEST_H_
\ No newline at end of file
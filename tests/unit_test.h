@@ -39,7 +39,8 @@ inline constexpr const char* formatString =
     throw "Assertion failed";                                          \
   }
 
-inline void run_all_tests() {
+// Returns the number of failed tests.
+inline int32_t run_all_tests() {
   int32_t passed = 0;
   int32_t failed = 0;
   for (const auto& testFunc : test_functions) {
@@ -58,6 +59,7 @@ inline void run_all_tests() {
   std::println("\n--- Test Summary ---");
   std::println("Passed: {}", passed);
   std::println("Failed: {}", failed);
+  return failed;
 }
 
 #endif  // UNIT_TEST_H_
\ No newline at end of file